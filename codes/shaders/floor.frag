@@ -6,37 +6,60 @@
 // - It is a variation of Phong lighting.
 // - It is faster than Phong lighting.
 // - It is used to calculate the lighting of the floor.
-out vec4 FragColor;
+// Variants: DIFFUSE_MAP and NORMAL_MAP select the texture paths at compile
+// time (see Shader_CreateVariant). IMPOSTOR reads the captured albedo and
+// object space normal through the same two paths, so far impostors are lit
+// and fogged exactly like the meshes they stand in for. IMPOSTOR_CAPTURE
+// writes those two unlit inputs instead of a colour.
+layout (location = 0) out vec4 FragColor;
+#ifdef IMPOSTOR_CAPTURE
+layout (location = 1) out vec4 CaptureNormal;
+#endif
 
 in vec3 FragPos;
 in vec2 TexCoord;
 in mat3 TBN;
 
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec4 plane;
+};
+
+layout (std140) uniform Lighting
+{
+    vec3 sunDir;
+    vec3 sunColor;
+    vec3 skyColor;
+    vec3 groundColor;
+};
+
 uniform sampler2D normalMap;
-uniform vec3 viewPos;
-uniform vec3 sunDir;
-uniform vec3 sunColor;
-uniform vec3 skyColor;
-uniform vec3 groundColor;
 uniform vec3 objectColor;
 uniform float shininess;
 uniform float specularIntensity;
 uniform sampler2D diffuseMap;
-uniform int useDiffuseMap;
-uniform int useNormalMap;
+uniform float fogDensity = 0.003;
 
 void main()
 {
+#ifdef IMPOSTOR
+    // Outside the captured silhouette
+    if (texture(diffuseMap, TexCoord).a < 0.5)
+        discard;
+#endif
+
     // 1. Obtain Normal
-    vec3 normal;
-    if (useNormalMap == 1) {
-        normal = texture(normalMap, TexCoord).rgb;
-        normal = normal * 2.0 - 1.0;   
-        normal = normalize(TBN * normal); 
-    } else {
-        // Use vertex normal (Z axis in TBN is the normal)
-        normal = normalize(TBN[2]);
-    } 
+#ifdef NORMAL_MAP
+    vec3 normal = texture(normalMap, TexCoord).rgb;
+    normal = normal * 2.0 - 1.0;   
+    normal = normalize(TBN * normal); 
+#else
+    // Use vertex normal (Z axis in TBN is the normal)
+    vec3 normal = normalize(TBN[2]);
+#endif
 
     // 2. Lighting (Blinn-Phong)
     vec3 viewDir = normalize(viewPos - FragPos);
@@ -57,10 +80,16 @@ void main()
     vec3 ambient = mix(groundColor, skyColor, hemiMix);
 
     // Base Color
+#ifdef DIFFUSE_MAP
+    vec3 baseColor = texture(diffuseMap, TexCoord).rgb;
+#else
     vec3 baseColor = objectColor;
-    if (useDiffuseMap == 1) {
-        baseColor = texture(diffuseMap, TexCoord).rgb;
-    }
+#endif
+#ifdef IMPOSTOR_CAPTURE
+    FragColor = vec4(baseColor, 1.0);
+    CaptureNormal = vec4(normal * 0.5 + 0.5, 1.0);
+    return;
+#endif
 
     // Combine Lighting
     vec3 lighting = ambient + diffuse + specular;
@@ -72,7 +101,6 @@ void main()
     
     // Atmospheric Fog (Distance based)
     float dist = length(viewPos - FragPos);
-    float fogDensity = 0.003; 
     float distFog = 1.0 - exp(-dist * dist * fogDensity * fogDensity);
     
     // Directional Fog (Z-based, for +Z direction)
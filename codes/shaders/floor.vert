@@ -1,33 +1,103 @@
 #version 330 core
+// Shared by every surface variant. With INSTANCED the model matrix comes
+// per instance from a buffer (location 4) instead of a uniform, so many
+// copies of a mesh are drawn in a single call. The normal matrix is
+// precomputed on the CPU either way (location 8 or a uniform).
+// IMPOSTOR (with INSTANCED) replaces the mesh by a quad (aPos.xy in
+// [-1, 1]) turned towards the camera around the object's up axis, textured
+// with the nearest of the yaw captures in the atlas. IMPOSTOR_CAPTURE draws
+// an unlit mesh into one atlas tile (see impostor.c).
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 layout (location = 3) in vec3 aTangent;
+#ifdef INSTANCED
+layout (location = 4) in mat4 aInstanceMatrix;
+layout (location = 8) in mat3 aInstanceNormalMatrix;
+#endif
 
 out vec3 FragPos;
 out vec2 TexCoord;
 out mat3 TBN;
 
+#ifndef INSTANCED
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec4 plane;
+uniform mat3 normalMatrix; // inverse transpose of mat3(model), from the CPU
+#endif
+#ifdef IMPOSTOR
+// Must match IMPOSTOR_FRAMES and IMPOSTOR_ATLAS_COLUMNS in impostor.h
+#define IMPOSTOR_FRAMES 16
+#define IMPOSTOR_ATLAS_COLUMNS 4
+uniform vec3 impostorCenter; // object space, the captures' centre
+uniform vec2 impostorExtent; // half width and half height of a capture
+// Object space = positionOffset + stored * positionScale, see Mesh
+uniform vec3 impostorPositionScale;
+uniform vec3 impostorPositionOffset;
+#endif
+#ifdef IMPOSTOR_CAPTURE
+uniform mat4 captureProjection; // object space to the current atlas tile
+#endif
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec4 plane;
+};
 
 void main()
 {
+#ifdef INSTANCED
+    mat4 model = aInstanceMatrix;
+    mat3 normalMatrix = aInstanceNormalMatrix;
+#endif
+#ifdef IMPOSTOR
+    // The instance matrix includes the dequantisation, so its inverse takes
+    // the eye to stored coordinates
+    vec3 eye = (inverse(model) * vec4(viewPos, 1.0)).xyz;
+    eye = impostorPositionOffset + eye * impostorPositionScale;
+    vec2 toEye = eye.xz - impostorCenter.xz;
+    if (dot(toEye, toEye) < 1e-8)
+        toEye = vec2(0.0, 1.0);
+    toEye = normalize(toEye);
+
+    // Frame k was captured from yaw k * 2pi / IMPOSTOR_FRAMES (0 = +z)
+    float yaw = atan(toEye.x, toEye.y);
+    int frame = int(floor(yaw * float(IMPOSTOR_FRAMES) / 6.2831853 + 0.5));
+    frame = (frame + IMPOSTOR_FRAMES) % IMPOSTOR_FRAMES;
+    vec2 tile = vec2(frame % IMPOSTOR_ATLAS_COLUMNS,
+                     frame / IMPOSTOR_ATLAS_COLUMNS);
+    const vec2 tiles = vec2(IMPOSTOR_ATLAS_COLUMNS,
+                            IMPOSTOR_FRAMES / IMPOSTOR_ATLAS_COLUMNS);
+    TexCoord = (tile + aPos.xy * 0.5 + 0.5) / tiles;
+
+    vec3 right = vec3(toEye.y, 0.0, -toEye.x);
+    vec3 corner = impostorCenter + right * (aPos.x * impostorExtent.x) +
+                  vec3(0.0, aPos.y * impostorExtent.y, 0.0);
+    corner = (corner - impostorPositionOffset) / impostorPositionScale;
+    vec4 worldPos = model * vec4(corner, 1.0);
+
+    // The atlas holds object space normals, which the normal matrix takes
+    // to world space the way TBN does for tangent space ones
+    TBN = normalMatrix;
+#else
     vec4 worldPos = model * vec4(aPos, 1.0);
-    FragPos = vec3(worldPos);
-    gl_ClipDistance[0] = dot(worldPos, plane); // Added as per instruction
     TexCoord = aTexCoord;
 
-    mat3 normalMatrix = transpose(inverse(mat3(model)));
     vec3 T = normalize(normalMatrix * aTangent);
     vec3 N = normalize(normalMatrix * aNormal);
     T = normalize(T - dot(T, N) * N); // Re-orthogonalize
     vec3 B = cross(N, T);
 
     TBN = mat3(T, B, N);
+#endif
+    FragPos = vec3(worldPos);
+    gl_ClipDistance[0] = dot(worldPos, plane); // Added as per instruction
 
+#ifdef IMPOSTOR_CAPTURE
+    gl_Position = captureProjection * worldPos;
+#else
     gl_Position = projection * view * vec4(FragPos, 1.0);
+#endif
 }
@@ -0,0 +1,24 @@
+#version 330 core
+// This shader is used to render god rays.
+// All rays share one cylinder mesh and are drawn in a single instanced call;
+// each instance supplies its own model matrix.
+layout (location = 0) in vec3 aPos;
+layout (location = 4) in mat4 aInstanceMatrix;
+
+out vec3 FragPos;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec4 plane;
+};
+
+void main()
+{
+    vec4 worldPos = aInstanceMatrix * vec4(aPos, 1.0);
+    FragPos = vec3(worldPos);
+    gl_ClipDistance[0] = dot(worldPos, plane);
+    gl_Position = projection * view * worldPos;
+}
@@ -1,32 +0,0 @@
-#version 330 core
-
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoord;
-layout (location = 3) in vec3 aTangent;
-
-out vec3 FragPos;
-out vec2 TexCoord;
-out mat3 TBN;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec4 plane;
-
-void main()
-{
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    gl_ClipDistance[0] = dot(vec4(FragPos, 1.0), plane);
-    TexCoord = aTexCoord;
-
-    mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 N = normalize(normalMatrix * aNormal);
-    T = normalize(T - dot(T, N) * N); // Re-orthogonalize
-    vec3 B = cross(N, T);
-
-    TBN = mat3(T, B, N);
-
-    gl_Position = projection * view * vec4(FragPos, 1.0);
-}
@@ -0,0 +1,17 @@
+#version 330 core
+// Depth of the big occluders for the Hi-Z pyramid (see occlusion.c)
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec4 plane;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
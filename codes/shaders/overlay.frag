@@ -0,0 +1,13 @@
+#version 330 core
+// Performance overlay: font atlas (or its white pixel) tinted by vertex color
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in vec4 Color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+    FragColor = Color * texture(atlas, TexCoord);
+}
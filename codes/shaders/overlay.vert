@@ -0,0 +1,17 @@
+#version 330 core
+// Performance overlay (Nuklear draw lists), pixel space in, NDC out
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec4 aColor;
+
+out vec2 TexCoord;
+out vec4 Color;
+
+uniform mat4 orthoProjection;
+
+void main()
+{
+    TexCoord = aTexCoord;
+    Color = aColor;
+    gl_Position = orthoProjection * vec4(aPos, 0.0, 1.0);
+}
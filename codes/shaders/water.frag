@@ -17,7 +17,14 @@ uniform sampler2D depthMap;
 
 uniform float moveFactor;
 uniform vec3 lightColor; // Sunset Orange: vec3(1.0, 0.6, 0.4)
-uniform vec3 skyColor;
+
+layout (std140) uniform Lighting
+{
+    vec3 sunDir;
+    vec3 sunColor;
+    vec3 skyColor;
+    vec3 groundColor;
+};
 
 // Sunset Tuning Constants
 const vec3 waterColor = vec3(0.1, 0.05, 0.2); // Deep Purple/Navy
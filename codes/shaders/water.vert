@@ -11,9 +11,13 @@ out vec3 fromLightVector;
 out vec4 worldPositionOut;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 cameraPosition;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec4 plane;
+};
 uniform vec3 lightPosition; // Or direction
 
 const float tiling = 1.0;
@@ -26,6 +30,6 @@ void main() {
     
     textureCoords = worldPosition.xz * tiling * 0.5;
     
-    toCameraVector = cameraPosition - worldPosition.xyz;
+    toCameraVector = viewPos - worldPosition.xyz;
     fromLightVector = worldPosition.xyz - lightPosition; // If lightPosition is actually direction, handle accordingly
 }
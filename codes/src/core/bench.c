@@ -0,0 +1,288 @@
+#include "bench.h"
+#include "../graphics/gl_state.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_FRAMES 600
+#define BENCH_DEFAULT_WARMUP 30
+#define BENCH_DEFAULT_OUT "bench_results.json"
+
+// Camera path control points: x, z, yaw, pitch. Walks the road from the
+// north end over the bridge to the south end, sweeping across the flower
+// beds and gazebos, then turns back towards the castle. Height comes from
+// the ground clamp in the main loop, like the walking camera.
+static const float pathPoints[][4] = {
+    {0.0f, 40.0f, -90.0f, 0.0f},    {-3.0f, 30.0f, -110.0f, -5.0f},
+    {3.0f, 20.0f, -70.0f, 5.0f},    {-2.0f, 10.0f, -120.0f, 0.0f},
+    {0.0f, 3.0f, -90.0f, 8.0f},     {0.0f, 0.0f, -90.0f, 0.0f},
+    {0.0f, -3.0f, -90.0f, -5.0f},   {3.0f, -12.0f, -45.0f, 0.0f},
+    {-3.0f, -24.0f, -135.0f, 5.0f}, {2.0f, -34.0f, -80.0f, 0.0f},
+    {0.0f, -40.0f, -270.0f, 10.0f},
+};
+#define PATH_POINT_COUNT (int)(sizeof(pathPoints) / sizeof(pathPoints[0]))
+
+static void usage(const char *prog) {
+  printf("Usage: %s [--bench [--bench-frames N] [--bench-warmup N] "
+         "[--bench-out file.json|file.csv]]\n",
+         prog);
+}
+
+int Bench_ParseArgs(Bench *bench, int argc, char **argv) {
+  memset(bench, 0, sizeof(*bench));
+  bench->frames = BENCH_DEFAULT_FRAMES;
+  bench->warmup = BENCH_DEFAULT_WARMUP;
+  bench->outPath = BENCH_DEFAULT_OUT;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    int hasValue = i + 1 < argc;
+    if (strcmp(arg, "--bench") == 0) {
+      bench->enabled = 1;
+    } else if (strcmp(arg, "--bench-frames") == 0 && hasValue) {
+      bench->frames = atoi(argv[++i]);
+    } else if (strcmp(arg, "--bench-warmup") == 0 && hasValue) {
+      bench->warmup = atoi(argv[++i]);
+    } else if (strcmp(arg, "--bench-out") == 0 && hasValue) {
+      bench->outPath = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 0;
+    }
+  }
+  if (bench->frames < 1 || bench->warmup < 0) {
+    usage(argv[0]);
+    return 0;
+  }
+  return 1;
+}
+
+void Bench_Init(Bench *bench, int width, int height) {
+  bench->width = width;
+  bench->height = height;
+
+  glGenFramebuffers(1, &bench->fbo);
+  GLState_BindFramebuffer(bench->fbo);
+  glGenRenderbuffers(1, &bench->colorRBO);
+  glBindRenderbuffer(GL_RENDERBUFFER, bench->colorRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, bench->colorRBO);
+  glGenRenderbuffers(1, &bench->depthRBO);
+  glBindRenderbuffer(GL_RENDERBUFFER, bench->depthRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, bench->depthRBO);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    Log_Error("Bench: offscreen framebuffer incomplete");
+  GLState_BindFramebuffer(0);
+
+  glGenQueries(BENCH_QUERY_LATENCY, bench->queries);
+  for (int i = 0; i < BENCH_QUERY_LATENCY; i++)
+    bench->queryFrame[i] = -1;
+
+  bench->cpuMs = (double *)calloc(bench->frames, sizeof(double));
+  bench->gpuMs = (double *)calloc(bench->frames, sizeof(double));
+  bench->frameMs = (double *)calloc(bench->frames, sizeof(double));
+
+  Log_Info("Bench: %d frames (+%d warmup) at %dx%d on %s", bench->frames,
+           bench->warmup, width, height,
+           (const char *)glGetString(GL_RENDERER));
+}
+
+int Bench_Done(const Bench *bench) {
+  return bench->frame >= bench->warmup + bench->frames;
+}
+
+static float catmullRom(float p0, float p1, float p2, float p3, float t) {
+  float t2 = t * t;
+  float t3 = t2 * t;
+  return 0.5f * (2.0f * p1 + (p2 - p0) * t +
+                 (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                 (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+void Bench_UpdateCamera(const Bench *bench, Camera *camera) {
+  int recorded = bench->frame - bench->warmup;
+  if (recorded < 0)
+    recorded = 0;
+  float t = bench->frames > 1 ? (float)recorded / (bench->frames - 1) : 0.0f;
+  float s = t * (PATH_POINT_COUNT - 1);
+  int seg = (int)s;
+  if (seg > PATH_POINT_COUNT - 2)
+    seg = PATH_POINT_COUNT - 2;
+  float u = s - seg;
+
+  // Clamp the neighbours at the ends of the path
+  int i0 = seg > 0 ? seg - 1 : 0;
+  int i3 = seg + 2 < PATH_POINT_COUNT ? seg + 2 : PATH_POINT_COUNT - 1;
+  float v[4];
+  for (int k = 0; k < 4; k++)
+    v[k] = catmullRom(pathPoints[i0][k], pathPoints[seg][k],
+                      pathPoints[seg + 1][k], pathPoints[i3][k], u);
+
+  camera->Position.x = v[0];
+  camera->Position.z = v[1];
+  camera->Yaw = v[2];
+  camera->Pitch = v[3];
+  Camera_UpdateVectors(camera);
+}
+
+void Bench_BeginFrame(Bench *bench) {
+  double now = glfwGetTime();
+  int prev = bench->frame - 1 - bench->warmup;
+  if (prev >= 0)
+    bench->frameMs[prev] = (now - bench->lastFrameStart) * 1000.0;
+  bench->lastFrameStart = now;
+
+  // Reuse the oldest query; reading it back only stalls if the GPU is more
+  // than BENCH_QUERY_LATENCY frames behind.
+  int slot = bench->frame % BENCH_QUERY_LATENCY;
+  int owner = bench->queryFrame[slot] - bench->warmup;
+  if (bench->queryFrame[slot] >= 0 && owner >= 0) {
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(bench->queries[slot], GL_QUERY_RESULT, &ns);
+    bench->gpuMs[owner] = ns / 1.0e6;
+  }
+  bench->queryFrame[slot] = bench->frame;
+  glBeginQuery(GL_TIME_ELAPSED, bench->queries[slot]);
+
+  bench->frameStart = glfwGetTime();
+}
+
+void Bench_EndFrame(Bench *bench) {
+  glEndQuery(GL_TIME_ELAPSED);
+  int recorded = bench->frame - bench->warmup;
+  if (recorded >= 0)
+    bench->cpuMs[recorded] = (glfwGetTime() - bench->frameStart) * 1000.0;
+  bench->frame++;
+}
+
+void Bench_BindTarget(const Bench *bench) {
+  GLState_BindFramebuffer(bench->fbo);
+  GLState_Viewport(0, 0, bench->width, bench->height);
+}
+
+typedef struct {
+  double mean, min, max, p50, p90, p95, p99;
+} BenchSummary;
+
+static int compareDouble(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentiles over a sorted copy
+static BenchSummary summarize(const double *values, int count) {
+  BenchSummary s;
+  double *sorted = (double *)malloc(count * sizeof(double));
+  memcpy(sorted, values, count * sizeof(double));
+  qsort(sorted, count, sizeof(double), compareDouble);
+
+  double sum = 0.0;
+  for (int i = 0; i < count; i++)
+    sum += sorted[i];
+  s.mean = sum / count;
+  s.min = sorted[0];
+  s.max = sorted[count - 1];
+  double pct[4] = {50.0, 90.0, 95.0, 99.0};
+  double *out[4] = {&s.p50, &s.p90, &s.p95, &s.p99};
+  for (int i = 0; i < 4; i++) {
+    int rank = (int)ceil(pct[i] / 100.0 * count);
+    *out[i] = sorted[rank > 0 ? rank - 1 : 0];
+  }
+  free(sorted);
+  return s;
+}
+
+static void writeSummaryJson(FILE *f, const char *name, BenchSummary s,
+                             int last) {
+  fprintf(f,
+          "    \"%s\": {\"mean\": %.4f, \"min\": %.4f, \"max\": %.4f, "
+          "\"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f}%s\n",
+          name, s.mean, s.min, s.max, s.p50, s.p90, s.p95, s.p99,
+          last ? "" : ",");
+}
+
+static void printSummary(const char *name, BenchSummary s) {
+  Log_Info("Bench: %-6s mean %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  "
+           "max %7.3f ms",
+           name, s.mean, s.p50, s.p95, s.p99, s.max);
+}
+
+int Bench_WriteResults(Bench *bench) {
+  // Close out the last frame and collect the queries still in flight
+  int last = bench->frame - 1 - bench->warmup;
+  if (last >= 0)
+    bench->frameMs[last] = (glfwGetTime() - bench->lastFrameStart) * 1000.0;
+  for (int slot = 0; slot < BENCH_QUERY_LATENCY; slot++) {
+    int owner = bench->queryFrame[slot] - bench->warmup;
+    if (bench->queryFrame[slot] < 0 || owner < 0)
+      continue;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(bench->queries[slot], GL_QUERY_RESULT, &ns);
+    bench->gpuMs[owner] = ns / 1.0e6;
+    bench->queryFrame[slot] = -1;
+  }
+
+  int count = bench->frame - bench->warmup;
+  if (count <= 0) {
+    Log_Error("Bench: no frames recorded");
+    return 0;
+  }
+  BenchSummary cpu = summarize(bench->cpuMs, count);
+  BenchSummary gpu = summarize(bench->gpuMs, count);
+  BenchSummary frame = summarize(bench->frameMs, count);
+
+  FILE *f = fopen(bench->outPath, "w");
+  if (!f) {
+    Log_Error("Bench: failed to open %s", bench->outPath);
+    return 0;
+  }
+
+  size_t len = strlen(bench->outPath);
+  if (len > 4 && strcmp(bench->outPath + len - 4, ".csv") == 0) {
+    fprintf(f, "frame,cpu_ms,gpu_ms,frame_ms\n");
+    for (int i = 0; i < count; i++)
+      fprintf(f, "%d,%.4f,%.4f,%.4f\n", i, bench->cpuMs[i], bench->gpuMs[i],
+              bench->frameMs[i]);
+  } else {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"renderer\": \"%s\",\n",
+            (const char *)glGetString(GL_RENDERER));
+    fprintf(f, "  \"width\": %d,\n  \"height\": %d,\n", bench->width,
+            bench->height);
+    fprintf(f, "  \"frames\": %d,\n  \"warmup\": %d,\n", count, bench->warmup);
+    fprintf(f, "  \"summary\": {\n");
+    writeSummaryJson(f, "cpu_ms", cpu, 0);
+    writeSummaryJson(f, "gpu_ms", gpu, 0);
+    writeSummaryJson(f, "frame_ms", frame, 1);
+    fprintf(f, "  },\n  \"samples\": [\n");
+    for (int i = 0; i < count; i++)
+      fprintf(f,
+              "    {\"frame\": %d, \"cpu_ms\": %.4f, \"gpu_ms\": %.4f, "
+              "\"frame_ms\": %.4f}%s\n",
+              i, bench->cpuMs[i], bench->gpuMs[i], bench->frameMs[i],
+              i + 1 < count ? "," : "");
+    fprintf(f, "  ]\n}\n");
+  }
+  fclose(f);
+
+  Log_Info("Bench: %d frames written to %s", count, bench->outPath);
+  printSummary("cpu", cpu);
+  printSummary("gpu", gpu);
+  printSummary("frame", frame);
+  return 1;
+}
+
+void Bench_Destroy(Bench *bench) {
+  glDeleteQueries(BENCH_QUERY_LATENCY, bench->queries);
+  glDeleteRenderbuffers(1, &bench->colorRBO);
+  glDeleteRenderbuffers(1, &bench->depthRBO);
+  glDeleteFramebuffers(1, &bench->fbo);
+  free(bench->cpuMs);
+  free(bench->gpuMs);
+  free(bench->frameMs);
+}
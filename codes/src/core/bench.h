@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "camera.h"
+#include "window.h"
+
+// Frames in flight before a GPU timer query is read back
+#define BENCH_QUERY_LATENCY 4
+
+// Headless benchmark: renders a fixed number of frames along a scripted
+// camera path into an offscreen framebuffer and records per-frame timings.
+typedef struct {
+  int enabled;
+  int frames;  // recorded frames
+  int warmup;  // frames rendered before recording starts
+  const char *outPath; // .csv writes CSV, anything else JSON
+
+  int frame; // current frame, counting warmup frames
+  int width, height;
+  GLuint fbo, colorRBO, depthRBO;
+  GLuint queries[BENCH_QUERY_LATENCY];
+  int queryFrame[BENCH_QUERY_LATENCY]; // frame a query belongs to, -1 if idle
+
+  double frameStart, lastFrameStart;
+  double *cpuMs;   // CPU time from Bench_BeginFrame to Bench_EndFrame
+  double *gpuMs;   // GL_TIME_ELAPSED of the same span
+  double *frameMs; // wall time between consecutive frame starts
+} Bench;
+
+// Parses --bench [--bench-frames N] [--bench-warmup N] [--bench-out path].
+// Returns 0 (after printing usage) on bad arguments.
+int Bench_ParseArgs(Bench *bench, int argc, char **argv);
+// Creates the offscreen target and timer queries. Needs the GL context.
+void Bench_Init(Bench *bench, int width, int height);
+int Bench_Done(const Bench *bench);
+// Places the camera on the path for the current frame
+void Bench_UpdateCamera(const Bench *bench, Camera *camera);
+void Bench_BeginFrame(Bench *bench);
+void Bench_EndFrame(Bench *bench);
+// Stands in for the default framebuffer in the final pass
+void Bench_BindTarget(const Bench *bench);
+// Drains pending queries, writes the results file and prints a summary
+int Bench_WriteResults(Bench *bench);
+void Bench_Destroy(Bench *bench);
+
+#endif
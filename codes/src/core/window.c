@@ -1,29 +1,72 @@
 #include "window.h"
+#include "../graphics/gl_state.h"
 #include <stdio.h>
 
-GLFWwindow *initWindow(int width, int height, const char *title) {
-  if (!glfwInit()) {
-    printf("Failed to initialize GLFW\n");
-    return NULL;
-  }
-
+static GLFWwindow *createContextWindow(int width, int height,
+                                       const char *title) {
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // Mac required
 
   GLFWwindow *window = glfwCreateWindow(width, height, title, NULL, NULL);
+  if (!window)
+    return NULL;
+
+  glfwMakeContextCurrent(window);
+
+  // Enable standard GL features
+  GLState_Enable(GL_DEPTH_TEST);
+  GLState_Enable(GL_CULL_FACE);
+
+  return window;
+}
+
+GLFWwindow *initWindow(int width, int height, const char *title) {
+  if (!glfwInit()) {
+    printf("Failed to initialize GLFW\n");
+    return NULL;
+  }
+
+  GLFWwindow *window = createContextWindow(width, height, title);
   if (!window) {
     printf("Failed to create GLFW window\n");
     glfwTerminate();
     return NULL;
   }
+  return window;
+}
 
-  glfwMakeContextCurrent(window);
+GLFWwindow *initWindowHeadless(int width, int height, const char *title) {
+#ifdef GLFW_PLATFORM_NULL
+  if (glfwPlatformSupported(GLFW_PLATFORM_NULL)) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (glfwInit()) {
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+      GLFWwindow *window = createContextWindow(width, height, title);
+      if (window) {
+        glfwSwapInterval(0);
+        return window;
+      }
+      glfwTerminate();
+    }
+    // No EGL driver; fall back to a hidden window on the native platform
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+  }
+#endif
 
-  // Enable standard GL features
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
+  if (!glfwInit()) {
+    printf("Failed to initialize GLFW\n");
+    return NULL;
+  }
 
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *window = createContextWindow(width, height, title);
+  if (!window) {
+    printf("Failed to create headless GLFW window\n");
+    glfwTerminate();
+    return NULL;
+  }
+  glfwSwapInterval(0);
   return window;
 }
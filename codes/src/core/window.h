@@ -14,5 +14,8 @@
 #include <GLFW/glfw3.h>
 
 GLFWwindow *initWindow(int width, int height, const char *title);
+// Invisible window for offscreen rendering. Prefers GLFW's null platform with
+// an EGL context so no display server is needed.
+GLFWwindow *initWindowHeadless(int width, int height, const char *title);
 
 #endif
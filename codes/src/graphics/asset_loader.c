@@ -0,0 +1,124 @@
+#include "asset_loader.h"
+#include "texture.h"
+#include "../utils/log.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef enum { ASSET_MODEL, ASSET_TEXTURE } AssetType;
+
+typedef struct AssetRequest {
+  AssetType type;
+  const char *path;
+  unsigned int meshFlags;
+  Mesh *outMesh;
+  GLuint *outTexture;
+  int ok;
+  MeshData mesh;
+  TextureData texture;
+  AssetLoader *loader;
+  struct AssetRequest *nextReady;
+} AssetRequest;
+
+struct AssetLoader {
+  ThreadPool *pool;
+  ThreadPoolGroup group;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  AssetRequest *readyHead; // decoded, waiting for the GL thread
+  int submitted;
+  double startTime;
+};
+
+AssetLoader *AssetLoader_Create(ThreadPool *pool) {
+  AssetLoader *loader = (AssetLoader *)calloc(1, sizeof(AssetLoader));
+  loader->pool = pool;
+  pthread_mutex_init(&loader->lock, NULL);
+  pthread_cond_init(&loader->ready, NULL);
+  loader->startTime = glfwGetTime();
+  return loader;
+}
+
+// Worker side: everything that does not need the GL context
+static void loadJob(void *arg) {
+  AssetRequest *req = (AssetRequest *)arg;
+  if (req->type == ASSET_MODEL)
+    req->ok = Mesh_LoadModelData(req->path, req->meshFlags, &req->mesh);
+  else
+    req->ok = Texture_Decode(req->path, &req->texture);
+
+  AssetLoader *loader = req->loader;
+  pthread_mutex_lock(&loader->lock);
+  req->nextReady = loader->readyHead;
+  loader->readyHead = req;
+  pthread_cond_signal(&loader->ready);
+  pthread_mutex_unlock(&loader->lock);
+}
+
+static void submit(AssetLoader *loader, AssetRequest *req) {
+  req->loader = loader;
+  loader->submitted++;
+  ThreadPool_Submit(loader->pool, &loader->group, loadJob, req);
+}
+
+void AssetLoader_AddModel(AssetLoader *loader, const char *path,
+                          unsigned int flags, Mesh *outMesh) {
+  AssetRequest *req = (AssetRequest *)calloc(1, sizeof(AssetRequest));
+  req->type = ASSET_MODEL;
+  req->path = path;
+  req->meshFlags = flags;
+  req->outMesh = outMesh;
+  submit(loader, req);
+}
+
+void AssetLoader_AddTexture(AssetLoader *loader, const char *path,
+                            GLuint *outTexture) {
+  AssetRequest *req = (AssetRequest *)calloc(1, sizeof(AssetRequest));
+  req->type = ASSET_TEXTURE;
+  req->path = path;
+  req->outTexture = outTexture;
+  submit(loader, req);
+}
+
+// GL side: upload and release the CPU copy
+static void upload(AssetRequest *req) {
+  if (req->type == ASSET_MODEL) {
+    Mesh empty = {0};
+    *req->outMesh =
+        req->ok ? Mesh_Upload(&req->mesh, MESH_FORMAT_COMPACT) : empty;
+    if (req->ok)
+      MeshData_Free(&req->mesh);
+  } else {
+    *req->outTexture = req->ok ? Texture_Upload(&req->texture) : 0;
+    if (req->ok)
+      TextureData_Free(&req->texture);
+  }
+}
+
+void AssetLoader_Finish(AssetLoader *loader) {
+  int uploaded = 0;
+  while (uploaded < loader->submitted) {
+    pthread_mutex_lock(&loader->lock);
+    while (!loader->readyHead)
+      pthread_cond_wait(&loader->ready, &loader->lock);
+    AssetRequest *batch = loader->readyHead;
+    loader->readyHead = NULL;
+    pthread_mutex_unlock(&loader->lock);
+
+    while (batch) {
+      AssetRequest *next = batch->nextReady;
+      upload(batch);
+      free(batch);
+      batch = next;
+      uploaded++;
+    }
+  }
+
+  // All jobs have signalled; wait so the group is quiescent before freeing
+  ThreadPool_Wait(loader->pool, &loader->group);
+  Log_Info("AssetLoader: %d assets loaded in %.0f ms", uploaded,
+           (glfwGetTime() - loader->startTime) * 1000.0);
+
+  pthread_cond_destroy(&loader->ready);
+  pthread_mutex_destroy(&loader->lock);
+  free(loader);
+}
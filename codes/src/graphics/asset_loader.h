@@ -0,0 +1,23 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "../utils/thread_pool.h"
+#include "mesh.h"
+
+// Loads models and textures in the background. Worker threads do the file
+// I/O, OBJ parsing/cache mapping and image decoding; the thread owning the GL
+// context performs the uploads in AssetLoader_Finish.
+typedef struct AssetLoader AssetLoader;
+
+AssetLoader *AssetLoader_Create(ThreadPool *pool);
+// *outMesh / *outTexture are written when the asset is uploaded; flags are
+// MESH_LOAD_* options
+void AssetLoader_AddModel(AssetLoader *loader, const char *path,
+                          unsigned int flags, Mesh *outMesh);
+void AssetLoader_AddTexture(AssetLoader *loader, const char *path,
+                            GLuint *outTexture);
+// Uploads assets as they become ready until all are done, then frees loader.
+// Must be called on the GL thread.
+void AssetLoader_Finish(AssetLoader *loader);
+
+#endif
@@ -0,0 +1,71 @@
+#include "culling.h"
+#include "render_stats.h"
+#include <math.h>
+
+Frustum Frustum_FromMatrix(mat4 viewProj) {
+  // Gribb/Hartmann: plane = row3 +- row{0,1,2} of the column-major matrix
+  const float *m = viewProj.m;
+  Frustum f;
+  for (int p = 0; p < 6; p++) {
+    int row = p / 2;
+    float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+    float a = m[3] + sign * m[row];
+    float b = m[7] + sign * m[4 + row];
+    float c = m[11] + sign * m[8 + row];
+    float d = m[15] + sign * m[12 + row];
+    float len = sqrtf(a * a + b * b + c * c);
+    if (len > 0.0f) {
+      a /= len;
+      b /= len;
+      c /= len;
+      d /= len;
+    }
+    f.planes[p][0] = a;
+    f.planes[p][1] = b;
+    f.planes[p][2] = c;
+    f.planes[p][3] = d;
+  }
+  return f;
+}
+
+int Frustum_TestSphere(const Frustum *frustum, const float center[3],
+                       float radius) {
+  for (int p = 0; p < 6; p++) {
+    const float *pl = frustum->planes[p];
+    if (pl[0] * center[0] + pl[1] * center[1] + pl[2] * center[2] + pl[3] <
+        -radius)
+      return 0;
+  }
+  return 1;
+}
+
+void Culling_TransformSphere(const Mesh *mesh, const float *model,
+                             float outCenter[3], float *outRadius) {
+  const float *c = mesh->boundsCenter;
+  for (int k = 0; k < 3; k++)
+    outCenter[k] = model[k] * c[0] + model[4 + k] * c[1] +
+                   model[8 + k] * c[2] + model[12 + k];
+
+  // Non-uniform scale: grow the radius by the largest axis scale
+  float maxScaleSq = 0.0f;
+  for (int col = 0; col < 3; col++) {
+    const float *axis = &model[col * 4];
+    float lenSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (lenSq > maxScaleSq)
+      maxScaleSq = lenSq;
+  }
+  *outRadius = mesh->boundsRadius * sqrtf(maxScaleSq);
+}
+
+int Culling_IsVisible(const Frustum *frustum, const Occlusion *occlusion,
+                      const Mesh *mesh, mat4 model) {
+  float center[3], radius;
+  Culling_TransformSphere(mesh, model.m, center, &radius);
+  int visible = Frustum_TestSphere(frustum, center, radius);
+  if (visible && !Occlusion_TestSphere(occlusion, center, radius)) {
+    visible = 0;
+    RenderStats_AddOcclusion(1);
+  }
+  RenderStats_AddCulling(visible, !visible);
+  return visible;
+}
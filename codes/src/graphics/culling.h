@@ -0,0 +1,28 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "../utils/math_utils.h"
+#include "mesh.h"
+#include "occlusion.h"
+
+// Six normalized planes (a, b, c, d) facing into the frustum:
+// left, right, bottom, top, near, far
+typedef struct {
+  float planes[6][4];
+} Frustum;
+
+// viewProj maps world space to clip space. With this repo's mat4_multiply
+// (which composes right-to-left) that is mat4_multiply(view, proj).
+Frustum Frustum_FromMatrix(mat4 viewProj);
+int Frustum_TestSphere(const Frustum *frustum, const float center[3],
+                       float radius);
+
+// World space bounding sphere of a mesh placed with model
+void Culling_TransformSphere(const Mesh *mesh, const float *model,
+                             float outCenter[3], float *outRadius);
+// Tests one placed mesh against the frustum, then the occlusion pyramid
+// (may be NULL), and records the outcome in the render stats
+int Culling_IsVisible(const Frustum *frustum, const Occlusion *occlusion,
+                      const Mesh *mesh, mat4 model);
+
+#endif
@@ -0,0 +1,145 @@
+#include "gl_state.h"
+#include <string.h>
+
+#define UNKNOWN 0xFFFFFFFFu
+
+enum { CAP_BLEND, CAP_CULL_FACE, CAP_DEPTH_TEST, CAP_SCISSOR_TEST, CAP_COUNT };
+
+typedef struct {
+  GLuint program;
+  GLuint vao;
+  GLuint activeUnit;
+  GLuint textures[GL_STATE_TEXTURE_UNITS];
+  int caps[CAP_COUNT]; // 0, 1 or -1 when unknown
+  GLenum blendSrc, blendDst;
+  GLenum depthFunc;
+  int depthMask;
+  GLuint framebuffer;
+  GLint viewport[4];
+} GLStateShadow;
+
+static GLStateShadow state;
+static GLStateStats stats;
+static int initialised = 0;
+
+void GLState_Invalidate(void) {
+  // 0xFF bytes make every handle and enum UNKNOWN and every flag -1
+  memset(&state, 0xFF, sizeof(state));
+  initialised = 1;
+}
+
+// Counts the call and reports whether it has to reach the driver
+static int needsCall(int same) {
+  if (!initialised) {
+    GLState_Invalidate();
+    same = 0;
+  }
+  if (same)
+    stats.filtered++;
+  else
+    stats.issued++;
+  return !same;
+}
+
+void GLState_UseProgram(GLuint program) {
+  if (needsCall(state.program == program)) {
+    glUseProgram(program);
+    state.program = program;
+  }
+}
+
+void GLState_BindVertexArray(GLuint vao) {
+  if (needsCall(state.vao == vao)) {
+    glBindVertexArray(vao);
+    state.vao = vao;
+  }
+}
+
+void GLState_BindTexture(int unit, GLuint texture) {
+  if (!needsCall(state.textures[unit] == texture))
+    return;
+  if (state.activeUnit != (GLuint)unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    state.activeUnit = (GLuint)unit;
+    stats.issued++;
+  }
+  glBindTexture(GL_TEXTURE_2D, texture);
+  state.textures[unit] = texture;
+}
+
+static int capIndex(GLenum cap) {
+  switch (cap) {
+  case GL_BLEND:
+    return CAP_BLEND;
+  case GL_CULL_FACE:
+    return CAP_CULL_FACE;
+  case GL_DEPTH_TEST:
+    return CAP_DEPTH_TEST;
+  case GL_SCISSOR_TEST:
+    return CAP_SCISSOR_TEST;
+  default:
+    return -1;
+  }
+}
+
+static void setCap(GLenum cap, int enabled) {
+  int i = capIndex(cap);
+  if (needsCall(i >= 0 && state.caps[i] == enabled)) {
+    if (enabled)
+      glEnable(cap);
+    else
+      glDisable(cap);
+    if (i >= 0)
+      state.caps[i] = enabled;
+  }
+}
+
+void GLState_Enable(GLenum cap) { setCap(cap, 1); }
+
+void GLState_Disable(GLenum cap) { setCap(cap, 0); }
+
+void GLState_BlendFunc(GLenum src, GLenum dst) {
+  if (needsCall(state.blendSrc == src && state.blendDst == dst)) {
+    glBlendFunc(src, dst);
+    state.blendSrc = src;
+    state.blendDst = dst;
+  }
+}
+
+void GLState_DepthFunc(GLenum func) {
+  if (needsCall(state.depthFunc == func)) {
+    glDepthFunc(func);
+    state.depthFunc = func;
+  }
+}
+
+void GLState_DepthMask(GLboolean mask) {
+  int value = mask ? 1 : 0;
+  if (needsCall(state.depthMask == value)) {
+    glDepthMask(mask);
+    state.depthMask = value;
+  }
+}
+
+void GLState_BindFramebuffer(GLuint framebuffer) {
+  if (needsCall(state.framebuffer == framebuffer)) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.framebuffer = framebuffer;
+  }
+}
+
+void GLState_Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  GLint v[4] = {x, y, width, height};
+  if (needsCall(memcmp(state.viewport, v, sizeof(v)) == 0)) {
+    glViewport(x, y, width, height);
+    memcpy(state.viewport, v, sizeof(v));
+  }
+}
+
+GLuint GLState_GetFramebuffer(void) { return state.framebuffer; }
+
+void GLState_GetViewport(GLint viewport[4]) {
+  memcpy(viewport, state.viewport, sizeof(state.viewport));
+}
+
+GLStateStats GLState_GetStats(void) { return stats; }
@@ -0,0 +1,41 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "../core/window.h"
+
+#define GL_STATE_TEXTURE_UNITS 8
+
+typedef struct {
+  int issued;   // GL calls made
+  int filtered; // calls skipped because the state was already set
+} GLStateStats;
+
+// Shadow copy of the context state the renderer changes. Each setter only
+// reaches the driver when the value differs from the last one set, so all
+// code must change this state through here. Starts unknown: the first call
+// of each kind is always issued.
+
+// Forgets the shadow, e.g. after code outside this layer touched the state
+void GLState_Invalidate(void);
+
+void GLState_UseProgram(GLuint program);
+void GLState_BindVertexArray(GLuint vao);
+// GL_TEXTURE_2D on the given unit; switches the active unit only if needed
+void GLState_BindTexture(int unit, GLuint texture);
+// GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST and GL_SCISSOR_TEST are tracked,
+// other capabilities are passed through
+void GLState_Enable(GLenum cap);
+void GLState_Disable(GLenum cap);
+void GLState_BlendFunc(GLenum src, GLenum dst);
+void GLState_DepthFunc(GLenum func);
+void GLState_DepthMask(GLboolean mask);
+void GLState_BindFramebuffer(GLuint framebuffer);
+void GLState_Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+// Last values set, for code that has to put them back
+GLuint GLState_GetFramebuffer(void);
+void GLState_GetViewport(GLint viewport[4]);
+
+// Cumulative since startup
+GLStateStats GLState_GetStats(void);
+
+#endif
@@ -0,0 +1,200 @@
+#include "impostor.h"
+#include "gl_state.h"
+#include "render_stats.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_ROWS (IMPOSTOR_FRAMES / IMPOSTOR_ATLAS_COLUMNS)
+#define ATLAS_WIDTH (IMPOSTOR_ATLAS_COLUMNS * IMPOSTOR_TILE_SIZE)
+#define ATLAS_HEIGHT (ATLAS_ROWS * IMPOSTOR_TILE_SIZE)
+
+static GLuint createAtlas(GLenum attachment) {
+  GLuint texture;
+  glGenTextures(1, &texture);
+  GLState_BindTexture(0, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture, 0);
+  return texture;
+}
+
+// Orthographic view of the bounds from yaw angle frame * 2pi / FRAMES
+// (0 looks from +z), column-major. x and y span the capture extent, depth
+// the bounding sphere.
+static void captureProjection(const Impostor *impostor, float radius,
+                              int frame, float *m) {
+  float yaw = (float)frame * 2.0f * (float)M_PI / IMPOSTOR_FRAMES;
+  float dirX = sinf(yaw), dirZ = cosf(yaw); // towards the eye
+  float rightX = dirZ, rightZ = -dirX;
+  const float *c = impostor->center;
+  float w = impostor->extent[0], h = impostor->extent[1];
+  memset(m, 0, 16 * sizeof(float));
+  m[0] = rightX / w;
+  m[8] = rightZ / w;
+  m[12] = -(c[0] * rightX + c[2] * rightZ) / w;
+  m[5] = 1.0f / h;
+  m[13] = -c[1] / h;
+  m[2] = -dirX / radius;
+  m[10] = -dirZ / radius;
+  m[14] = (c[0] * dirX + c[2] * dirZ) / radius;
+  m[15] = 1.0f;
+}
+
+static void capture(Impostor *impostor, Mesh *mesh, GLuint program,
+                    GLuint normalMap, GLuint diffuseMap) {
+  GLuint frameBuffer, depthBuffer;
+  glGenFramebuffers(1, &frameBuffer);
+  GLState_BindFramebuffer(frameBuffer);
+  impostor->albedo = createAtlas(GL_COLOR_ATTACHMENT0);
+  impostor->normals = createAtlas(GL_COLOR_ATTACHMENT1);
+  glGenRenderbuffers(1, &depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, ATLAS_WIDTH,
+                        ATLAS_HEIGHT);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depthBuffer);
+  GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, buffers);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    Log_Error("Impostor: capture framebuffer is not complete");
+
+  GLState_Viewport(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT);
+  GLState_DepthMask(GL_TRUE);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  // Drawn in object space, so the normals come out in object space too
+  const float identity3[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  mat4 position = Mesh_PositionMatrix(mesh, identity());
+  Shader_Use(program);
+  Shader_SetMat4(program, "model", position.m);
+  Shader_SetMat3(program, "normalMatrix", identity3);
+  Shader_SetVec3(program, "objectColor", 1.0f, 1.0f, 1.0f);
+  if (normalMap)
+    GLState_BindTexture(0, normalMap);
+  if (diffuseMap)
+    GLState_BindTexture(1, diffuseMap);
+  for (int frame = 0; frame < IMPOSTOR_FRAMES; frame++) {
+    float projection[16];
+    captureProjection(impostor, mesh->boundsRadius, frame, projection);
+    Shader_SetMat4(program, "captureProjection", projection);
+    GLState_Viewport(frame % IMPOSTOR_ATLAS_COLUMNS * IMPOSTOR_TILE_SIZE,
+                     frame / IMPOSTOR_ATLAS_COLUMNS * IMPOSTOR_TILE_SIZE,
+                     IMPOSTOR_TILE_SIZE, IMPOSTOR_TILE_SIZE);
+    Mesh_Draw(mesh);
+  }
+
+  GLState_BindFramebuffer(0);
+  glDeleteRenderbuffers(1, &depthBuffer);
+  glDeleteFramebuffers(1, &frameBuffer);
+  GLState_BindTexture(0, impostor->albedo);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  GLState_BindTexture(0, impostor->normals);
+  glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+static void setupQuad(Impostor *impostor, int instanceCount) {
+  // Corners in the order of a triangle strip facing the eye
+  const float corners[8] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                            -1.0f, 1.0f,  1.0f, 1.0f};
+  glGenVertexArrays(1, &impostor->VAO);
+  GLState_BindVertexArray(impostor->VAO);
+  glGenBuffers(1, &impostor->quadVBO);
+  glBindBuffer(GL_ARRAY_BUFFER, impostor->quadVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                        (void *)0);
+  glEnableVertexAttribArray(0);
+
+  // Same records as the batch: model matrix at 4-7, normal matrix at 8-10
+  GLsizei strideBytes = MESH_INSTANCE_FLOATS * sizeof(float);
+  glGenBuffers(1, &impostor->instanceVBO);
+  glBindBuffer(GL_ARRAY_BUFFER, impostor->instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER, instanceCount * strideBytes, NULL,
+               GL_STREAM_DRAW);
+  for (int col = 0; col < 4; col++)
+    glVertexAttribPointer(4 + col, 4, GL_FLOAT, GL_FALSE, strideBytes,
+                          (void *)(col * 4 * sizeof(float)));
+  for (int col = 0; col < 3; col++)
+    glVertexAttribPointer(8 + col, 3, GL_FLOAT, GL_FALSE, strideBytes,
+                          (void *)((16 + col * 3) * sizeof(float)));
+  for (int i = 0; i < 7; i++) {
+    glEnableVertexAttribArray(4 + i);
+    glVertexAttribDivisor(4 + i, 1);
+  }
+  GLState_BindVertexArray(0);
+}
+
+int Impostor_Init(Impostor *impostor, StaticBatch *batch, float distance,
+                  GLuint captureProgram, GLuint normalMap, GLuint diffuseMap) {
+  memset(impostor, 0, sizeof(Impostor));
+  Mesh *mesh = batch->mesh;
+  if (batch->count == 0 || mesh->indexCount == 0)
+    return 0;
+
+  // The quad turns about the up axis, so it has to cover the bounds seen
+  // from any yaw
+  for (int k = 0; k < 3; k++)
+    impostor->center[k] = mesh->boundsCenter[k];
+  float halfX = 0.5f * (mesh->boundsMax[0] - mesh->boundsMin[0]);
+  float halfY = 0.5f * (mesh->boundsMax[1] - mesh->boundsMin[1]);
+  float halfZ = 0.5f * (mesh->boundsMax[2] - mesh->boundsMin[2]);
+  impostor->extent[0] = fmaxf(sqrtf(halfX * halfX + halfZ * halfZ), 1e-4f);
+  impostor->extent[1] = fmaxf(halfY, 1e-4f);
+
+  capture(impostor, mesh, captureProgram, normalMap, diffuseMap);
+  setupQuad(impostor, batch->count);
+  impostor->visible =
+      (float *)malloc(batch->count * MESH_INSTANCE_FLOATS * sizeof(float));
+  impostor->batch = batch;
+  batch->impostorDistance = distance;
+  Log_Info("Impostor: %d frames of %dx%d beyond %.0f units",
+           IMPOSTOR_FRAMES, IMPOSTOR_TILE_SIZE, IMPOSTOR_TILE_SIZE, distance);
+  return 1;
+}
+
+void Impostor_Draw(Impostor *impostor, GLuint program, const Frustum *frustum,
+                   const Occlusion *occlusion, int reflectionPass,
+                   const LodView *view) {
+  int count =
+      StaticBatch_CollectImpostors(impostor->batch, frustum, occlusion,
+                                   reflectionPass, view, impostor->visible);
+  if (count == 0)
+    return;
+
+  if (impostor->program != program) {
+    impostor->program = program;
+    impostor->centerUniform = Shader_GetUniform(program, "impostorCenter");
+    impostor->extentUniform = Shader_GetUniform(program, "impostorExtent");
+    impostor->positionScaleUniform =
+        Shader_GetUniform(program, "impostorPositionScale");
+    impostor->positionOffsetUniform =
+        Shader_GetUniform(program, "impostorPositionOffset");
+  }
+  const Mesh *mesh = impostor->batch->mesh;
+  Shader_UniformVec3(impostor->centerUniform, impostor->center[0],
+                     impostor->center[1], impostor->center[2]);
+  Shader_UniformVec2(impostor->extentUniform, impostor->extent[0],
+                     impostor->extent[1]);
+  Shader_UniformVec3(impostor->positionScaleUniform, mesh->positionScale[0],
+                     mesh->positionScale[1], mesh->positionScale[2]);
+  Shader_UniformVec3(impostor->positionOffsetUniform, mesh->positionOffset[0],
+                     mesh->positionOffset[1], mesh->positionOffset[2]);
+
+  // Respecifying the store lets the driver orphan the copy still in flight
+  glBindBuffer(GL_ARRAY_BUFFER, impostor->instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               count * sizeof(float) * MESH_INSTANCE_FLOATS,
+               impostor->visible, GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  GLState_BindVertexArray(impostor->VAO);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+  RenderStats_AddDraw(6, count); // two triangles each
+}
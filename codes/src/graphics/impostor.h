@@ -0,0 +1,49 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include "culling.h"
+#include "shader.h"
+#include "static_batch.h"
+
+// Yaw angles captured around the object's up axis. Both must match the
+// defines in floor.vert.
+#define IMPOSTOR_FRAMES 16
+#define IMPOSTOR_ATLAS_COLUMNS 4
+#define IMPOSTOR_TILE_SIZE 128 // pixels per capture
+
+// Stand-in for the far instances of a static batch: its mesh rendered once
+// at startup from IMPOSTOR_FRAMES yaw angles into an albedo and an object
+// space normal atlas, then drawn as one camera facing quad per instance.
+// The two atlases take the diffuse and normal map slots of a Material, so
+// the quads go through floor.frag's lighting and fog like the mesh does.
+typedef struct {
+  StaticBatch *batch;
+  GLuint albedo;  // RGBA, alpha marks the silhouette
+  GLuint normals; // object space normals packed into [0, 1]
+  float center[3]; // object space centre of the captures
+  float extent[2]; // half width and half height of a capture
+  GLuint VAO;
+  GLuint quadVBO;
+  GLuint instanceVBO;
+  float *visible; // scratch for the far instance records
+  // Uniforms of the program last drawn with
+  GLuint program;
+  ShaderUniform centerUniform;
+  ShaderUniform extentUniform;
+  ShaderUniform positionScaleUniform;
+  ShaderUniform positionOffsetUniform;
+} Impostor;
+
+// Captures the built batch's mesh with captureProgram, an IMPOSTOR_CAPTURE
+// variant sampling the given maps (0 for none), and hands the instances at
+// least distance away to the impostor. Returns 0 and leaves the batch alone
+// when there is nothing to capture.
+int Impostor_Init(Impostor *impostor, StaticBatch *batch, float distance,
+                  GLuint captureProgram, GLuint normalMap, GLuint diffuseMap);
+// Expects program, the currently used INSTANCED | IMPOSTOR | DIFFUSE_MAP |
+// NORMAL_MAP variant, with the atlases bound as its maps
+void Impostor_Draw(Impostor *impostor, GLuint program, const Frustum *frustum,
+                   const Occlusion *occlusion, int reflectionPass,
+                   const LodView *view);
+
+#endif
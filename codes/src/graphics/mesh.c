@@ -2,12 +2,20 @@
 partially optimized performance
 */
 #include "mesh.h"
+#include "gl_state.h"
+#include "mesh_cache.h"
+#include "mesh_cluster.h"
+#include "mesh_optimize.h"
+#include "mesh_simplify.h"
+#include "render_stats.h"
+#include "../utils/log.h"
+#include "../utils/obj_parser.h"
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 Mesh Mesh_CreatePlane(float size) {
-  Mesh mesh;
   float halfSize = size / 2.0f;
 
   // 4 vertices (Quad)
@@ -38,39 +46,17 @@ Mesh Mesh_CreatePlane(float size) {
       -halfSize, 0.0f, halfSize,  0.0f, 1.0f, 0.0f, uv00_u, uv00_v, tx, ty, tz};
   unsigned int indices[] = {0, 2, 1, 0, 3, 2}; // CCW
 
-  mesh.indexCount = 6;
-
-  glGenVertexArrays(1, &mesh.VAO);
-  glGenBuffers(1, &mesh.VBO);
-  glGenBuffers(1, &mesh.EBO);
-
-  glBindVertexArray(mesh.VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
-               GL_STATIC_DRAW);
-
-  // Attribs
-  int stride = 11 * sizeof(float);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(6 * sizeof(float)));
-  glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(8 * sizeof(float)));
-
-  glBindVertexArray(0);
-  return mesh;
+  MeshData data = {0};
+  data.vertices = vertices;
+  data.indices = indices;
+  data.vertexCount = 4;
+  data.indexCount = 6;
+  data.boundsMin[0] = data.boundsMin[2] = -halfSize;
+  data.boundsMax[0] = data.boundsMax[2] = halfSize;
+  return Mesh_Upload(&data, 0);
 }
 
 Mesh Mesh_CreateCube(float width, float height, float depth) {
-  Mesh mesh;
   float hw = width / 2.0f;
   float hh = height / 2.0f;
   float hd = depth / 2.0f;
@@ -217,161 +203,165 @@ Mesh Mesh_CreateCube(float width, float height, float depth) {
       20, 22, 21, 22, 20, 23  // Right
   };
 
-  mesh.indexCount = 36;
+  MeshData data = {0};
+  data.vertices = vertices;
+  data.indices = indices;
+  data.vertexCount = 24;
+  data.indexCount = 36;
+  data.boundsMin[0] = -hw;
+  data.boundsMin[1] = -hh;
+  data.boundsMin[2] = -hd;
+  data.boundsMax[0] = hw;
+  data.boundsMax[1] = hh;
+  data.boundsMax[2] = hd;
+  return Mesh_Upload(&data, 0);
+}
 
-  glGenVertexArrays(1, &mesh.VAO);
-  glGenBuffers(1, &mesh.VBO);
-  glGenBuffers(1, &mesh.EBO);
+void Mesh_Draw(Mesh *mesh) { Mesh_DrawLod(mesh, 0); }
 
-  glBindVertexArray(mesh.VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
-               GL_STATIC_DRAW);
+static const void *lodIndices(const Mesh *mesh, int lod) {
+  size_t indexBytes = mesh->indexType == GL_UNSIGNED_SHORT
+                          ? sizeof(uint16_t)
+                          : sizeof(unsigned int);
+  return (const void *)((size_t)mesh->lods[lod].indexOffset * indexBytes);
+}
 
-  int stride = 11 * sizeof(float);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(6 * sizeof(float)));
-  glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(8 * sizeof(float)));
+void Mesh_DrawLod(Mesh *mesh, int lod) {
+  // The VAO stays bound; the next draw's bind replaces it
+  GLState_BindVertexArray(mesh->VAO);
+  int count = mesh->lods[lod].indexCount;
+  glDrawElements(GL_TRIANGLES, count, mesh->indexType,
+                 lodIndices(mesh, lod));
+  RenderStats_AddDraw(count, 1);
+}
 
-  glBindVertexArray(0);
-  return mesh;
+void Mesh_DrawRanges(Mesh *mesh, const GLsizei *counts,
+                     const void *const *offsets, int rangeCount) {
+  GLState_BindVertexArray(mesh->VAO);
+  glMultiDrawElements(GL_TRIANGLES, counts, mesh->indexType, offsets,
+                      rangeCount);
+  int total = 0;
+  for (int i = 0; i < rangeCount; i++)
+    total += counts[i];
+  RenderStats_AddDraw(total, 1);
 }
 
-void Mesh_Draw(Mesh *mesh) {
-  glBindVertexArray(mesh->VAO);
-  glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
+LodView LodView_Make(vec3 position, mat4 projection, int viewportHeight) {
+  LodView view;
+  view.position[0] = position.x;
+  view.position[1] = position.y;
+  view.position[2] = position.z;
+  // projection[1][1] is cot(fov / 2): NDC units per world unit at distance 1
+  view.pixelScale = projection.m[5] * 0.5f * (float)viewportHeight;
+  return view;
+}
+
+int Mesh_SelectLod(const Mesh *mesh, const LodView *view,
+                   const float center[3], float radius) {
+  if (mesh->lodCount <= 1)
+    return 0;
+  float dx = center[0] - view->position[0];
+  float dy = center[1] - view->position[1];
+  float dz = center[2] - view->position[2];
+  float distance = sqrtf(dx * dx + dy * dy + dz * dz) - radius;
+  if (distance <= 0.0f)
+    return 0;
+  // Errors are in object space; the sphere tells how the placement scaled it
+  float scale = mesh->boundsRadius > 0.0f ? radius / mesh->boundsRadius : 1.0f;
+  float pixelsPerUnit = scale * view->pixelScale / distance;
+  int lod = 0;
+  while (lod + 1 < mesh->lodCount &&
+         mesh->lods[lod + 1].error * pixelsPerUnit <= MESH_LOD_PIXEL_ERROR)
+    lod++;
+  return lod;
 }
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Simple OBJ Loader (Replaces Assimp)
-Mesh Mesh_LoadModel(const char *path) {
-  Mesh mesh = {0};
-  FILE *file = fopen(path, "r");
-  if (!file) {
-    printf("ERROR::OBJ::Could not open file: %s\n", path);
-    return mesh;
-  }
+// Open addressing hash map from an OBJ (v, vt, vn) triple to the index of
+// the welded output vertex.
+typedef struct {
+  int v, vt, vn, index; // index < 0 marks an empty slot
+} WeldEntry;
+
+typedef struct {
+  WeldEntry *entries;
+  unsigned int mask;
+} WeldMap;
+
+static void weldMapInit(WeldMap *map, int maxKeys) {
+  unsigned int cap = 64;
+  while (cap < (unsigned int)maxKeys * 2)
+    cap <<= 1;
+  map->entries = (WeldEntry *)malloc(cap * sizeof(WeldEntry));
+  for (unsigned int i = 0; i < cap; i++)
+    map->entries[i].index = -1;
+  map->mask = cap - 1;
+}
 
-  // Dynamic arrays for parsing
-  int vCap = 4096, vtCap = 4096, vnCap = 4096, fCap = 4096;
-  int vCount = 0, vtCount = 0, vnCount = 0, fCount = 0;
-
-  float *temp_v = (float *)malloc(vCap * 3 * sizeof(float));
-  float *temp_vt = (float *)malloc(vtCap * 2 * sizeof(float));
-  float *temp_vn = (float *)malloc(vnCap * 3 * sizeof(float));
-
-  // Face structure: 3 vertices per face (triangulated)
-  typedef struct {
-    int v[3], vt[3], vn[3];
-  } Face;
-  Face *temp_f = (Face *)malloc(fCap * sizeof(Face));
-
-  char line[512];
-  int lineCount = 0;
-  while (fgets(line, sizeof(line), file)) {
-    lineCount++;
-    if (lineCount <= 5) {
-      printf("DEBUG::OBJ::Line %d: %s", lineCount, line);
-    }
-    // Vertex Position
-    if (strncmp(line, "v ", 2) == 0) {
-      if (vCount >= vCap) {
-        vCap *= 2;
-        temp_v = (float *)realloc(temp_v, vCap * 3 * sizeof(float));
-      }
-      sscanf(line, "v %f %f %f", &temp_v[vCount * 3], &temp_v[vCount * 3 + 1],
-             &temp_v[vCount * 3 + 2]);
-      vCount++;
+static void weldMapFree(WeldMap *map) { free(map->entries); }
+
+// Returns the index stored for the key, inserting newIndex if it is absent
+static int weldMapInsert(WeldMap *map, int v, int vt, int vn, int newIndex,
+                         int *isNew) {
+  unsigned int h = (unsigned int)v * 73856093u ^ (unsigned int)vt * 19349663u ^
+                   (unsigned int)vn * 83492791u;
+  for (unsigned int i = h & map->mask;; i = (i + 1) & map->mask) {
+    WeldEntry *e = &map->entries[i];
+    if (e->index < 0) {
+      e->v = v;
+      e->vt = vt;
+      e->vn = vn;
+      e->index = newIndex;
+      *isNew = 1;
+      return newIndex;
     }
-    // Texture Coordinate
-    else if (strncmp(line, "vt ", 3) == 0) {
-      if (vtCount >= vtCap) {
-        vtCap *= 2;
-        temp_vt = (float *)realloc(temp_vt, vtCap * 2 * sizeof(float));
-      }
-      sscanf(line, "vt %f %f", &temp_vt[vtCount * 2],
-             &temp_vt[vtCount * 2 + 1]);
-      vtCount++;
-    }
-    // Vertex Normal
-    else if (strncmp(line, "vn ", 3) == 0) {
-      if (vnCount >= vnCap) {
-        vnCap *= 2;
-        temp_vn = (float *)realloc(temp_vn, vnCap * 3 * sizeof(float));
-      }
-      sscanf(line, "vn %f %f %f", &temp_vn[vnCount * 3],
-             &temp_vn[vnCount * 3 + 1], &temp_vn[vnCount * 3 + 2]);
-      vnCount++;
-    }
-    // Face
-    else if (strncmp(line, "f ", 2) == 0) {
-      // Parse face indices
-      int v[4] = {0}, vt[4] = {0}, vn[4] = {0};
-      int count = 0;
-      char *token = strtok(line + 2, " \t\r\n");
-      while (token != NULL && count < 4) {
-        // Try v/vt/vn
-        if (sscanf(token, "%d/%d/%d", &v[count], &vt[count], &vn[count]) != 3) {
-          // Try v//vn
-          if (sscanf(token, "%d//%d", &v[count], &vn[count]) != 2) {
-            // Try v/vt
-            if (sscanf(token, "%d/%d", &v[count], &vt[count]) != 2) {
-              // Try v
-              sscanf(token, "%d", &v[count]);
-            }
-          }
-        }
-        count++;
-        token = strtok(NULL, " \t\r\n");
-      }
-
-      // Triangulate (Fan triangulation: 0-1-2, 0-2-3)
-      for (int i = 0; i < count - 2; i++) {
-        if (fCount >= fCap) {
-          fCap *= 2;
-          temp_f = (Face *)realloc(temp_f, fCap * sizeof(Face));
-        }
-        // Triangle 1: 0, i+1, i+2
-        int idxs[3] = {0, i + 1, i + 2};
-        for (int k = 0; k < 3; k++) {
-          int idx = idxs[k];
-          temp_f[fCount].v[k] = (v[idx] > 0) ? v[idx] - 1 : 0;
-          temp_f[fCount].vt[k] = (vt[idx] > 0) ? vt[idx] - 1 : 0;
-          temp_f[fCount].vn[k] = (vn[idx] > 0) ? vn[idx] - 1 : 0;
-        }
-        fCount++;
-      }
+    if (e->v == v && e->vt == vt && e->vn == vn) {
+      *isNew = 0;
+      return e->index;
     }
   }
-  fclose(file);
-
-  printf("Mesh_LoadModel: Loaded %s. Verts: %d, UVs: %d, Normals: %d, Faces: "
-         "%d\n",
-         path, vCount, vtCount, vnCount, fCount);
+}
 
-  // Construct final mesh (Triangle Soup)
-  int numVertices = fCount * 3;
+// Simple OBJ Loader (Replaces Assimp)
+// Parses the OBJ at path into an indexed, interleaved mesh.
+static int parseObj(const char *path, MeshData *out) {
+  // Parse v/vt/vn/f records (mmapped, in parallel for large files)
+  ObjData obj;
+  if (!ObjParser_Parse(path, ThreadPool_GetDefault(), &obj)) {
+    Log_Error("OBJ: could not open file: %s", path);
+    return 0;
+  }
+  int vCount = obj.positionCount, vtCount = obj.texcoordCount;
+  int vnCount = obj.normalCount, fCount = obj.faceCount;
+  const float *temp_v = obj.positions;
+  const float *temp_vt = obj.texcoords;
+  const float *temp_vn = obj.normals;
+  const ObjFace *temp_f = obj.faces;
+
+  Log_Debug("Mesh_LoadModel: Loaded %s. Verts: %d, UVs: %d, Normals: %d, "
+            "Faces: %d",
+            path, vCount, vtCount, vnCount, fCount);
+
+  // Construct final mesh (Indexed)
+  // Corners sharing the same (v, vt, vn) triple are welded into one vertex so
+  // the index buffer gets real reuse instead of 3 unique vertices per face.
+  int numVertices = 0;
   int numIndices = fCount * 3;
   int stride = 11; // Pos(3), Normal(3), UV(2), Tangent(3)
 
-  float *vertices = (float *)malloc(numVertices * stride * sizeof(float));
+  float *vertices = (float *)malloc(numIndices * stride * sizeof(float));
   unsigned int *indices =
       (unsigned int *)malloc(numIndices * sizeof(unsigned int));
 
+  WeldMap weld;
+  weldMapInit(&weld, numIndices);
+
+  float boundsMin[3] = {INFINITY, INFINITY, INFINITY};
+  float boundsMax[3] = {-INFINITY, -INFINITY, -INFINITY};
+
   for (int i = 0; i < fCount; i++) {
     // Calculate Tangent for the triangle
     float p1[3], p2[3], p3[3];
@@ -450,15 +440,33 @@ Mesh Mesh_LoadModel(const char *path) {
     }
 
     for (int j = 0; j < 3; j++) {
-      int vIdx = i * 3 + j;
       int vIndex = temp_f[i].v[j];
       int vtIndex = temp_f[i].vt[j];
       int vnIndex = temp_f[i].vn[j];
 
+      int isNew;
+      int vIdx = weldMapInsert(&weld, vIndex, vtIndex, vnIndex, numVertices,
+                               &isNew);
+      indices[i * 3 + j] = (unsigned int)vIdx;
+
+      if (!isNew) {
+        // Shared corner: accumulate the face tangent, averaged below
+        vertices[vIdx * stride + 8] += tangent[0];
+        vertices[vIdx * stride + 9] += tangent[1];
+        vertices[vIdx * stride + 10] += tangent[2];
+        continue;
+      }
+      numVertices++;
+
       // Pos
       vertices[vIdx * stride + 0] = temp_v[vIndex * 3];
       vertices[vIdx * stride + 1] = temp_v[vIndex * 3 + 1];
       vertices[vIdx * stride + 2] = temp_v[vIndex * 3 + 2];
+      for (int k = 0; k < 3; k++) {
+        float p = vertices[vIdx * stride + k];
+        boundsMin[k] = (p < boundsMin[k]) ? p : boundsMin[k];
+        boundsMax[k] = (p > boundsMax[k]) ? p : boundsMax[k];
+      }
 
       // Normal
       if (vnCount > 0) {
@@ -484,92 +492,322 @@ Mesh Mesh_LoadModel(const char *path) {
       vertices[vIdx * stride + 8] = tangent[0];
       vertices[vIdx * stride + 9] = tangent[1];
       vertices[vIdx * stride + 10] = tangent[2];
+    }
+  }
 
-      indices[vIdx] = vIdx;
+  // Average the accumulated tangents of welded vertices
+  for (int v = 0; v < numVertices; v++) {
+    float *t = &vertices[v * stride + 8];
+    float len = sqrtf(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+    if (len > 0.0001f) {
+      t[0] /= len;
+      t[1] /= len;
+      t[2] /= len;
+    } else {
+      t[0] = 1.0f;
+      t[1] = 0.0f;
+      t[2] = 0.0f;
     }
   }
+  weldMapFree(&weld);
+  vertices =
+      (float *)realloc(vertices, (numVertices + 1) * stride * sizeof(float));
+
+  Log_Debug("Mesh_LoadModel: Welded %d corners into %d vertices", numIndices,
+            numVertices);
 
   // Cleanup temp arrays
-  free(temp_v);
-  free(temp_vt);
-  free(temp_vn);
-  free(temp_f);
+  ObjData_Free(&obj);
+
+  memset(out, 0, sizeof(*out));
+  out->vertices = vertices;
+  out->indices = indices;
+  out->vertexCount = numVertices;
+  out->indexCount = numIndices;
+  for (int k = 0; k < 3; k++) {
+    out->boundsMin[k] = (fCount > 0) ? boundsMin[k] : 0.0f;
+    out->boundsMax[k] = (fCount > 0) ? boundsMax[k] : 0.0f;
+  }
+  return 1;
+}
+
+void MeshData_Free(MeshData *data) {
+  if (data->mapping) {
+    MeshCache_Unmap(data);
+  } else {
+    free(data->vertices);
+    free(data->indices);
+    free(data->clusters);
+  }
+  memset(data, 0, sizeof(*data));
+}
 
-  mesh.indexCount = numIndices;
+// Round to nearest even; overflow saturates to infinity
+static uint16_t packHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (uint16_t)((bits >> 16) & 0x8000u);
+  int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+  uint32_t mantissa = bits & 0x7FFFFFu;
+  if (exponent >= 31)
+    return sign | 0x7C00u;
+  int shift = 13;
+  if (exponent <= 0) {
+    // Subnormal half: the implicit one becomes part of the mantissa
+    if (exponent < -10)
+      return sign;
+    mantissa |= 0x800000u;
+    shift = 14 - exponent;
+    exponent = 0;
+  }
+  uint32_t half = (uint32_t)exponent << 10 | mantissa >> shift;
+  uint32_t rest = mantissa & ((1u << shift) - 1);
+  uint32_t halfway = 1u << (shift - 1);
+  if (rest > halfway || (rest == halfway && (half & 1)))
+    half++; // a carry correctly rolls into the exponent
+  return sign | (uint16_t)half;
+}
+
+// Signed normalized x, y, z into GL_INT_2_10_10_10_REV, w = 0
+static uint32_t packSnorm1010102(const float *v) {
+  uint32_t packed = 0;
+  for (int k = 0; k < 3; k++) {
+    float c = fminf(fmaxf(v[k], -1.0f), 1.0f);
+    packed |= ((uint32_t)lroundf(c * 511.0f) & 0x3FFu) << (10 * k);
+  }
+  return packed;
+}
+
+// Creates the GL buffers for an interleaved mesh. The data may point straight
+// into a memory-mapped cache file.
+Mesh Mesh_Upload(const MeshData *data, unsigned int format) {
+  Mesh mesh = {0};
+  if (data->lodCount > 0) {
+    memcpy(mesh.lods, data->lods, sizeof(mesh.lods));
+    mesh.lodCount = data->lodCount;
+  } else {
+    mesh.lods[0].indexCount = data->indexCount;
+    mesh.lodCount = 1;
+  }
+  mesh.indexCount = mesh.lods[0].indexCount;
+  if (data->clusterCount > 0) {
+    size_t bytes = data->clusterCount * sizeof(MeshCluster);
+    mesh.clusters = (MeshCluster *)malloc(bytes);
+    memcpy(mesh.clusters, data->clusters, bytes);
+    mesh.clusterCount = data->clusterCount;
+  }
+
+  float radiusSq = 0.0f;
+  for (int k = 0; k < 3; k++) {
+    float half = 0.5f * (data->boundsMax[k] - data->boundsMin[k]);
+    mesh.boundsMin[k] = data->boundsMin[k];
+    mesh.boundsMax[k] = data->boundsMax[k];
+    mesh.boundsCenter[k] = data->boundsMin[k] + half;
+    radiusSq += half * half;
+    mesh.positionScale[k] = 1.0f;
+    if (format & MESH_FORMAT_QUANTIZED_POSITION) {
+      // Normalized int16 spans [-1, 1] across the box
+      mesh.positionScale[k] = half > 0.0f ? half : 1.0f;
+      mesh.positionOffset[k] = mesh.boundsCenter[k];
+    }
+  }
+  mesh.boundsRadius = sqrtf(radiusSq);
+
+  // Pos | Normal | Tangent | UV, positions padded to 4 shorts for alignment
+  int quantized = (format & MESH_FORMAT_QUANTIZED_POSITION) != 0;
+  int halfUV = (format & MESH_FORMAT_HALF_UV) != 0;
+  size_t posBytes = quantized ? 4 * sizeof(int16_t) : 3 * sizeof(float);
+  size_t normalOffset = posBytes;
+  size_t tangentOffset = normalOffset + sizeof(uint32_t);
+  size_t uvOffset = tangentOffset + sizeof(uint32_t);
+  size_t strideBytes =
+      uvOffset + (halfUV ? 2 * sizeof(uint16_t) : 2 * sizeof(float));
+
+  unsigned char *packed =
+      (unsigned char *)malloc((size_t)data->vertexCount * strideBytes);
+  for (int i = 0; i < data->vertexCount; i++) {
+    const float *v = data->vertices + (size_t)i * MESH_VERTEX_FLOATS;
+    unsigned char *out = packed + (size_t)i * strideBytes;
+    if (quantized) {
+      int16_t q[4] = {0, 0, 0, 0};
+      for (int k = 0; k < 3; k++) {
+        float n = (v[k] - mesh.positionOffset[k]) / mesh.positionScale[k];
+        q[k] = (int16_t)lroundf(fminf(fmaxf(n, -1.0f), 1.0f) * 32767.0f);
+      }
+      memcpy(out, q, sizeof(q));
+    } else {
+      memcpy(out, v, 3 * sizeof(float));
+    }
+    uint32_t normal = packSnorm1010102(v + 3);
+    uint32_t tangent = packSnorm1010102(v + 8);
+    memcpy(out + normalOffset, &normal, sizeof(normal));
+    memcpy(out + tangentOffset, &tangent, sizeof(tangent));
+    if (halfUV) {
+      uint16_t uv[2] = {packHalf(v[6]), packHalf(v[7])};
+      memcpy(out + uvOffset, uv, sizeof(uv));
+    } else {
+      memcpy(out + uvOffset, v + 6, 2 * sizeof(float));
+    }
+  }
 
   glGenVertexArrays(1, &mesh.VAO);
   glGenBuffers(1, &mesh.VBO);
   glGenBuffers(1, &mesh.EBO);
 
-  glBindVertexArray(mesh.VAO);
+  GLState_BindVertexArray(mesh.VAO);
   glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-  glBufferData(GL_ARRAY_BUFFER, numVertices * stride * sizeof(float), vertices,
-               GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)data->vertexCount * strideBytes,
+               packed, GL_STATIC_DRAW);
+  free(packed);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int),
-               indices, GL_STATIC_DRAW);
+  if (data->vertexCount <= 65536) {
+    // Every index fits in 16 bits, halving the index buffer
+    uint16_t *shortIndices =
+        (uint16_t *)malloc((size_t)data->indexCount * sizeof(uint16_t));
+    for (int i = 0; i < data->indexCount; i++)
+      shortIndices[i] = (uint16_t)data->indices[i];
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 (GLsizeiptr)data->indexCount * sizeof(uint16_t), shortIndices,
+                 GL_STATIC_DRAW);
+    free(shortIndices);
+    mesh.indexType = GL_UNSIGNED_SHORT;
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 (GLsizeiptr)data->indexCount * sizeof(unsigned int),
+                 data->indices, GL_STATIC_DRAW);
+    mesh.indexType = GL_UNSIGNED_INT;
+  }
 
   // Attribs
-  int strideBytes = stride * sizeof(float);
+  GLsizei stride = (GLsizei)strideBytes;
   glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, strideBytes, (void *)0);
+  if (quantized)
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void *)0);
+  else
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, strideBytes,
-                        (void *)(3 * sizeof(float)));
+  glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                        (void *)normalOffset);
   glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, strideBytes,
-                        (void *)(6 * sizeof(float)));
+  glVertexAttribPointer(2, 2, halfUV ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE,
+                        stride, (void *)uvOffset);
   glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, strideBytes,
-                        (void *)(8 * sizeof(float)));
+  glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                        (void *)tangentOffset);
 
-  glBindVertexArray(0);
+  GLState_BindVertexArray(0);
+  return mesh;
+}
 
-  free(vertices);
-  free(indices);
+// Loads a model into CPU memory, preferring the binary cache next to the
+// OBJ. A cache miss parses the OBJ once and writes the cache for the next
+// start. Does not touch GL, so it can run on a worker thread.
+int Mesh_LoadModelData(const char *path, unsigned int flags, MeshData *out) {
+  if (MeshCache_Load(path, flags, out)) {
+    Log_Debug("Mesh_LoadModel: Loaded %s from cache. Verts: %d, Indices: %d",
+              path, out->vertexCount, out->indexCount);
+    return 1;
+  }
+  if (!parseObj(path, out))
+    return 0;
+  MeshOptimize_Run(out, path);
+  MeshSimplify_BuildLods(out, path);
+  if (flags & MESH_LOAD_CLUSTERS)
+    MeshCluster_Build(out, path);
+  MeshCache_Store(path, flags, out);
+  return 1;
+}
 
+Mesh Mesh_LoadModel(const char *path, unsigned int flags) {
+  MeshData data;
+  if (!Mesh_LoadModelData(path, flags, &data)) {
+    Mesh empty = {0};
+    return empty;
+  }
+
+  Mesh mesh = Mesh_Upload(&data, MESH_FORMAT_COMPACT);
+  MeshData_Free(&data);
   return mesh;
 }
 
-void Mesh_SetupInstanced(Mesh *mesh, int instanceCount, const float *matrices) {
+mat4 Mesh_PositionMatrix(const Mesh *mesh, mat4 model) {
+  const float *s = mesh->positionScale;
+  const float *o = mesh->positionOffset;
+  if (s[0] == 1.0f && s[1] == 1.0f && s[2] == 1.0f && o[0] == 0.0f &&
+      o[1] == 0.0f && o[2] == 0.0f)
+    return model;
+  // model * translate(offset) * scale(scale)
+  mat4 dequantize =
+      mat4_multiply(scale(s[0], s[1], s[2]), translate(o[0], o[1], o[2]));
+  return mat4_multiply(dequantize, model);
+}
+
+void Mesh_PackInstance(const Mesh *mesh, mat4 model, float *out) {
+  mat4 position = Mesh_PositionMatrix(mesh, model);
+  memcpy(out, position.m, 16 * sizeof(float));
+  mat4_normal_matrix(model, out + 16);
+}
+
+// GL 3.3 has no base instance, so drawing from the middle of the instance
+// buffer means moving the attribute pointers. Expects the VAO bound.
+static void pointInstanceAttribs(Mesh *mesh, int firstInstance) {
+  // Model matrix: vec4 * 4 at locations 4-7, normal matrix: vec3 * 3 at 8-10
+  GLsizei strideBytes = MESH_INSTANCE_FLOATS * sizeof(float);
+  size_t base = (size_t)firstInstance * strideBytes;
+  glBindBuffer(GL_ARRAY_BUFFER, mesh->instanceVBO);
+  for (int col = 0; col < 4; col++)
+    glVertexAttribPointer(4 + col, 4, GL_FLOAT, GL_FALSE, strideBytes,
+                          (void *)(base + col * 4 * sizeof(float)));
+  for (int col = 0; col < 3; col++)
+    glVertexAttribPointer(8 + col, 3, GL_FLOAT, GL_FALSE, strideBytes,
+                          (void *)(base + (16 + col * 3) * sizeof(float)));
+  mesh->instanceBase = firstInstance;
+}
+
+void Mesh_SetupInstanced(Mesh *mesh, int instanceCount,
+                         const float *instances) {
   glGenBuffers(1, &mesh->instanceVBO);
   glBindBuffer(GL_ARRAY_BUFFER, mesh->instanceVBO);
-  glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(float) * 16, matrices,
+  glBufferData(GL_ARRAY_BUFFER,
+               instanceCount * sizeof(float) * MESH_INSTANCE_FLOATS, instances,
                GL_STATIC_DRAW);
 
-  glBindVertexArray(mesh->VAO);
-  // Vertex Attributes
-  // vec4 * 4
-  glEnableVertexAttribArray(4);
-  glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
-                        (void *)0);
-  glEnableVertexAttribArray(5);
-  glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
-                        (void *)(4 * sizeof(float)));
-  glEnableVertexAttribArray(6);
-  glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
-                        (void *)(8 * sizeof(float)));
-  glEnableVertexAttribArray(7);
-  glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
-                        (void *)(12 * sizeof(float)));
-
-  glVertexAttribDivisor(4, 1);
-  glVertexAttribDivisor(5, 1);
-  glVertexAttribDivisor(6, 1);
-  glVertexAttribDivisor(7, 1);
-
-  glBindVertexArray(0);
+  GLState_BindVertexArray(mesh->VAO);
+  for (int i = 0; i < 7; i++) {
+    glEnableVertexAttribArray(4 + i);
+    glVertexAttribDivisor(4 + i, 1);
+  }
+  pointInstanceAttribs(mesh, 0);
+
+  GLState_BindVertexArray(0);
+}
+
+void Mesh_UpdateInstances(Mesh *mesh, int instanceCount,
+                          const float *instances) {
+  // Respecifying the store lets the driver orphan the copy still in flight
+  glBindBuffer(GL_ARRAY_BUFFER, mesh->instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               instanceCount * sizeof(float) * MESH_INSTANCE_FLOATS, instances,
+               GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void Mesh_DrawInstanced(Mesh *mesh, int instanceCount) {
-  glBindVertexArray(mesh->VAO);
-  glDrawElementsInstanced(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, 0,
-                          instanceCount);
-  glBindVertexArray(0);
+  Mesh_DrawInstancedLod(mesh, 0, 0, instanceCount);
+}
+
+void Mesh_DrawInstancedLod(Mesh *mesh, int lod, int firstInstance,
+                           int instanceCount) {
+  GLState_BindVertexArray(mesh->VAO);
+  if (mesh->instanceBase != firstInstance)
+    pointInstanceAttribs(mesh, firstInstance);
+  int count = mesh->lods[lod].indexCount;
+  glDrawElementsInstanced(GL_TRIANGLES, count, mesh->indexType,
+                          lodIndices(mesh, lod), instanceCount);
+  RenderStats_AddDraw(count, instanceCount);
 }
 
 Mesh Mesh_CreateCylinder(float radius, float height, int segments) {
-  Mesh mesh;
   int vertexCount = (segments + 1) * 2; // Top and bottom rings
   int indexCount = segments * 6;        // 2 triangles per segment
 
@@ -633,35 +871,17 @@ Mesh Mesh_CreateCylinder(float radius, float height, int segments) {
     }
   }
 
-  mesh.indexCount = indexCount;
-
-  glGenVertexArrays(1, &mesh.VAO);
-  glGenBuffers(1, &mesh.VBO);
-  glGenBuffers(1, &mesh.EBO);
-
-  glBindVertexArray(mesh.VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-  glBufferData(GL_ARRAY_BUFFER, vertexCount * 11 * sizeof(float), vertices,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int),
-               indices, GL_STATIC_DRAW);
-
-  // Attribs
-  int stride = 11 * sizeof(float);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(6 * sizeof(float)));
-  glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride,
-                        (void *)(8 * sizeof(float)));
+  MeshData data = {0};
+  data.vertices = vertices;
+  data.indices = indices;
+  data.vertexCount = vertexCount;
+  data.indexCount = indexCount;
+  data.boundsMin[0] = data.boundsMin[2] = -radius;
+  data.boundsMin[1] = -halfHeight;
+  data.boundsMax[0] = data.boundsMax[2] = radius;
+  data.boundsMax[1] = halfHeight;
+  Mesh mesh = Mesh_Upload(&data, 0);
 
-  glBindVertexArray(0);
   free(vertices);
   free(indices);
 
@@ -2,21 +2,132 @@
 #define MESH_H
 
 #include "../core/window.h"
+#include "../utils/math_utils.h"
+#include <stddef.h>
+
+// Interleaved CPU side (and cache) layout: Pos(3), Normal(3), UV(2),
+// Tangent(3). Mesh_Upload packs it into the GPU format.
+#define MESH_VERTEX_FLOATS 11
+// GPU vertex formats for Mesh_Upload. Normals and tangents are always
+// GL_INT_2_10_10_10_REV; without flags positions and UVs stay float (28 bytes)
+#define MESH_FORMAT_QUANTIZED_POSITION (1u << 0) // int16 across the bounds
+#define MESH_FORMAT_HALF_UV (1u << 1)            // for UVs of small magnitude
+#define MESH_FORMAT_COMPACT                                                    \
+  (MESH_FORMAT_QUANTIZED_POSITION | MESH_FORMAT_HALF_UV) // 20 bytes
+// Cooking options for Mesh_LoadModelData, part of the cache's identity.
+// Clusters only pay off for meshes drawn one placement at a time; they cost
+// instanced meshes vertex cache efficiency for nothing.
+#define MESH_LOAD_CLUSTERS (1u << 0) // split level 0, see mesh_cluster.h
+// Per instance record: model matrix (16) then normal matrix (9), both
+// column-major, read as attributes 4-7 and 8-10
+#define MESH_INSTANCE_FLOATS 25
+// Detail levels per mesh, level 0 being the full mesh
+#define MESH_MAX_LODS 4
+// A coarser level is used once its error projects to at most this many
+// pixels
+#define MESH_LOD_PIXEL_ERROR 2.0f
+
+// One detail level: a range of the shared index buffer
+typedef struct {
+  int indexOffset;
+  int indexCount;
+  float error; // object space distance from the full mesh, 0 for level 0
+} MeshLod;
+
+// A range of level 0 culled on its own (see mesh_cluster.h), with its
+// object space bounding sphere and the cone holding its face normals
+typedef struct {
+  int indexOffset;
+  int indexCount;
+  float center[3];
+  float radius;
+  float coneAxis[3];
+  float coneCutoff; // sine of the cone's half angle, 1 when it never culls
+} MeshCluster;
 
 typedef struct {
   GLuint VAO;
   GLuint VBO;
   GLuint EBO;
   int indexCount;
+  GLenum indexType; // GL_UNSIGNED_SHORT whenever the vertex count allows
   GLuint instanceVBO;
+  int instanceBase; // first instance the attribute pointers address
+  MeshLod lods[MESH_MAX_LODS];
+  int lodCount;
+  MeshCluster *clusters; // CPU copy for culling, NULL when not clustered
+  int clusterCount;
+  // Object space bounds, set by Mesh_Upload
+  float boundsMin[3];
+  float boundsMax[3];
+  float boundsCenter[3];
+  float boundsRadius; // sphere around boundsCenter enclosing the AABB
+  // Object space position = positionOffset + stored * positionScale; the
+  // identity unless uploaded with MESH_FORMAT_QUANTIZED_POSITION
+  float positionScale[3];
+  float positionOffset[3];
 } Mesh;
 
+// CPU side mesh, either parsed from OBJ or mapped from the binary cache
+typedef struct {
+  float *vertices;
+  unsigned int *indices;
+  int vertexCount;
+  int indexCount;
+  float boundsMin[3];
+  float boundsMax[3];
+  // Levels stored back to back in indices; lodCount 0 means one level
+  // spanning all of them
+  MeshLod lods[MESH_MAX_LODS];
+  int lodCount;
+  // Level 0 split into clusters covering it in order; none unless loaded
+  // with MESH_LOAD_CLUSTERS, nor for small meshes
+  MeshCluster *clusters;
+  int clusterCount;
+  void *mapping; // non-NULL when vertices/indices point into a mapped file
+  size_t mappingSize;
+} MeshData;
+
+// Camera that detail levels are chosen for
+typedef struct {
+  float position[3];
+  float pixelScale; // pixels covered by one world unit at distance 1
+} LodView;
+
 Mesh Mesh_CreatePlane(float size);
 Mesh Mesh_CreateCube(float width, float height, float depth);
 Mesh Mesh_CreateCylinder(float radius, float height, int segments);
-Mesh Mesh_LoadModel(const char *path);
+// flags are MESH_LOAD_* options
+Mesh Mesh_LoadModel(const char *path, unsigned int flags);
+int Mesh_LoadModelData(const char *path, unsigned int flags, MeshData *out);
+Mesh Mesh_Upload(const MeshData *data, unsigned int format);
+void MeshData_Free(MeshData *data);
+// Draws level 0
 void Mesh_Draw(Mesh *mesh);
-void Mesh_SetupInstanced(Mesh *mesh, int instanceCount, const float *matrices);
+void Mesh_DrawLod(Mesh *mesh, int lod);
+// Draws several index ranges (e.g. visible clusters) in one
+// glMultiDrawElements call; offsets are in bytes like glDrawElements'
+void Mesh_DrawRanges(Mesh *mesh, const GLsizei *counts,
+                     const void *const *offsets, int rangeCount);
+LodView LodView_Make(vec3 position, mat4 projection, int viewportHeight);
+// Coarsest level whose error stays within MESH_LOD_PIXEL_ERROR for a
+// placement with the given world space bounding sphere
+int Mesh_SelectLod(const Mesh *mesh, const LodView *view,
+                   const float center[3], float radius);
+// Model matrix to draw with: model with the position dequantisation folded
+// in. Normal matrices still come from model itself.
+mat4 Mesh_PositionMatrix(const Mesh *mesh, mat4 model);
+// Writes the MESH_INSTANCE_FLOATS record for one placement
+void Mesh_PackInstance(const Mesh *mesh, mat4 model, float *out);
+void Mesh_SetupInstanced(Mesh *mesh, int instanceCount,
+                         const float *instances);
+// Replaces the instance records (e.g. with the visible subset) in place
+void Mesh_UpdateInstances(Mesh *mesh, int instanceCount,
+                          const float *instances);
 void Mesh_DrawInstanced(Mesh *mesh, int instanceCount);
+// Draws instanceCount records starting at firstInstance of the instance
+// buffer at the given level
+void Mesh_DrawInstancedLod(Mesh *mesh, int lod, int firstInstance,
+                           int instanceCount);
 
 #endif
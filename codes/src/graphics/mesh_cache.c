@@ -0,0 +1,151 @@
+#include "mesh_cache.h"
+#include "../utils/log.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout: header, vertices (vertexCount * 11 floats),
+// indices (indexCount * uint32, every detail level back to back),
+// clusters (clusterCount * MeshCluster, all 4-byte fields). Every block is
+// 4-byte aligned so the mapped pointers can be handed to glBufferData
+// directly.
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t sourceSize;
+  int64_t sourceMtime;
+  uint32_t loadFlags; // MESH_LOAD_* the data was cooked with
+  uint32_t vertexFloats;
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  float boundsMin[3];
+  float boundsMax[3];
+  uint32_t lodCount;
+  MeshLod lods[MESH_MAX_LODS];
+  uint32_t clusterCount;
+} MeshCacheHeader;
+
+static const char MESH_CACHE_MAGIC[4] = {'S', 'J', 'M', 'C'};
+
+static void cachePathFor(const char *sourcePath, char *out, size_t outSize) {
+  snprintf(out, outSize, "%s.meshcache", sourcePath);
+}
+
+int MeshCache_Load(const char *sourcePath, unsigned int flags, MeshData *out) {
+  struct stat src;
+  if (stat(sourcePath, &src) != 0)
+    return 0;
+
+  char cachePath[1024];
+  cachePathFor(sourcePath, cachePath, sizeof(cachePath));
+  int fd = open(cachePath, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MeshCacheHeader)) {
+    close(fd);
+    return 0;
+  }
+
+  size_t size = (size_t)st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping stays valid after close
+  if (map == MAP_FAILED)
+    return 0;
+
+  const MeshCacheHeader *h = (const MeshCacheHeader *)map;
+  size_t expected = sizeof(MeshCacheHeader) +
+                    (size_t)h->vertexCount * h->vertexFloats * sizeof(float) +
+                    (size_t)h->indexCount * sizeof(uint32_t) +
+                    (size_t)h->clusterCount * sizeof(MeshCluster);
+  if (memcmp(h->magic, MESH_CACHE_MAGIC, 4) != 0 ||
+      h->version != MESH_CACHE_VERSION || h->loadFlags != flags ||
+      h->vertexFloats != MESH_VERTEX_FLOATS ||
+      h->sourceSize != (uint64_t)src.st_size ||
+      h->sourceMtime != (int64_t)src.st_mtime || expected != size ||
+      h->lodCount > MESH_MAX_LODS) {
+    munmap(map, size);
+    return 0;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->vertices = (float *)((char *)map + sizeof(MeshCacheHeader));
+  out->indices = (unsigned int *)(out->vertices +
+                                  (size_t)h->vertexCount * h->vertexFloats);
+  out->vertexCount = (int)h->vertexCount;
+  out->indexCount = (int)h->indexCount;
+  memcpy(out->boundsMin, h->boundsMin, sizeof(out->boundsMin));
+  memcpy(out->boundsMax, h->boundsMax, sizeof(out->boundsMax));
+  memcpy(out->lods, h->lods, sizeof(out->lods));
+  out->lodCount = (int)h->lodCount;
+  if (h->clusterCount > 0)
+    out->clusters = (MeshCluster *)(out->indices + h->indexCount);
+  out->clusterCount = (int)h->clusterCount;
+  out->mapping = map;
+  out->mappingSize = size;
+
+  // Hint the kernel that the whole file is about to be read by the upload
+  madvise(map, size, MADV_WILLNEED);
+  return 1;
+}
+
+void MeshCache_Unmap(MeshData *data) {
+  if (data->mapping)
+    munmap(data->mapping, data->mappingSize);
+  data->mapping = NULL;
+  data->mappingSize = 0;
+}
+
+int MeshCache_Store(const char *sourcePath, unsigned int flags,
+                    const MeshData *data) {
+  struct stat src;
+  if (stat(sourcePath, &src) != 0)
+    return 0;
+
+  MeshCacheHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MESH_CACHE_MAGIC, 4);
+  h.version = MESH_CACHE_VERSION;
+  h.sourceSize = (uint64_t)src.st_size;
+  h.sourceMtime = (int64_t)src.st_mtime;
+  h.loadFlags = flags;
+  h.vertexFloats = MESH_VERTEX_FLOATS;
+  h.vertexCount = (uint32_t)data->vertexCount;
+  h.indexCount = (uint32_t)data->indexCount;
+  memcpy(h.boundsMin, data->boundsMin, sizeof(h.boundsMin));
+  memcpy(h.boundsMax, data->boundsMax, sizeof(h.boundsMax));
+  h.lodCount = (uint32_t)data->lodCount;
+  memcpy(h.lods, data->lods, sizeof(h.lods));
+  h.clusterCount = (uint32_t)data->clusterCount;
+
+  // Write to a temporary file and rename so a reader never maps a partial
+  // cache (e.g. if the program is killed while cooking).
+  char cachePath[1024], tmpPath[1040];
+  cachePathFor(sourcePath, cachePath, sizeof(cachePath));
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", cachePath);
+
+  FILE *f = fopen(tmpPath, "wb");
+  if (!f)
+    return 0;
+  size_t vBytes =
+      (size_t)data->vertexCount * MESH_VERTEX_FLOATS * sizeof(float);
+  size_t iBytes = (size_t)data->indexCount * sizeof(uint32_t);
+  size_t cBytes = (size_t)data->clusterCount * sizeof(MeshCluster);
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(data->vertices, 1, vBytes, f) == vBytes &&
+           fwrite(data->indices, 1, iBytes, f) == iBytes &&
+           (cBytes == 0 || fwrite(data->clusters, 1, cBytes, f) == cBytes);
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(tmpPath, cachePath) != 0) {
+    remove(tmpPath);
+    Log_Warn("MeshCache: could not write %s", cachePath);
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,21 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mesh.h"
+
+// Binary mesh cache stored next to the source model as "<path>.meshcache".
+// Bump MESH_CACHE_VERSION whenever the cooked layout or processing changes.
+#define MESH_CACHE_VERSION 6
+
+// Maps the cache for sourcePath cooked with the given MESH_LOAD_* flags into
+// out. Returns 0 when the cache is missing, stale (source size/mtime
+// changed), cooked with other flags or from another version.
+int MeshCache_Load(const char *sourcePath, unsigned int flags, MeshData *out);
+// Writes data, cooked with flags, as the cache for sourcePath. Failures are
+// not fatal.
+int MeshCache_Store(const char *sourcePath, unsigned int flags,
+                    const MeshData *data);
+// Releases the mapping of a MeshData filled by MeshCache_Load.
+void MeshCache_Unmap(MeshData *data);
+
+#endif
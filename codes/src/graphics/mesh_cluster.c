@@ -0,0 +1,297 @@
+#include "mesh_cluster.h"
+#include "mesh_optimize.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Unit face normal from the winding, zero for degenerate triangles
+static void faceNormal(const float *vertices, const unsigned int *triangle,
+                       float n[3]) {
+  const float *a = vertices + (size_t)triangle[0] * MESH_VERTEX_FLOATS;
+  const float *b = vertices + (size_t)triangle[1] * MESH_VERTEX_FLOATS;
+  const float *c = vertices + (size_t)triangle[2] * MESH_VERTEX_FLOATS;
+  float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+  float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  for (int k = 0; k < 3; k++)
+    n[k] = len > 0.0f ? n[k] / len : 0.0f;
+}
+
+// Sphere around the box of the cluster's vertices, and the cone around the
+// mean normal reaching every face normal
+static void computeBounds(const MeshData *data, const float *normals,
+                          const int *order, MeshCluster *cluster) {
+  const unsigned int *indices = data->indices + cluster->indexOffset;
+  int count = cluster->indexCount;
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (int i = 0; i < count; i++) {
+    const float *p = data->vertices + (size_t)indices[i] * MESH_VERTEX_FLOATS;
+    for (int k = 0; k < 3; k++) {
+      lo[k] = fminf(lo[k], p[k]);
+      hi[k] = fmaxf(hi[k], p[k]);
+    }
+  }
+  float radiusSq = 0.0f;
+  for (int k = 0; k < 3; k++)
+    cluster->center[k] = 0.5f * (lo[k] + hi[k]);
+  for (int i = 0; i < count; i++) {
+    const float *p = data->vertices + (size_t)indices[i] * MESH_VERTEX_FLOATS;
+    float dx = p[0] - cluster->center[0];
+    float dy = p[1] - cluster->center[1];
+    float dz = p[2] - cluster->center[2];
+    radiusSq = fmaxf(radiusSq, dx * dx + dy * dy + dz * dz);
+  }
+  cluster->radius = sqrtf(radiusSq);
+
+  float axis[3] = {0.0f, 0.0f, 0.0f};
+  int triangles = count / 3;
+  for (int t = 0; t < triangles; t++)
+    for (int k = 0; k < 3; k++)
+      axis[k] += normals[order[t] * 3 + k];
+  float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  cluster->coneCutoff = 1.0f;
+  memset(cluster->coneAxis, 0, sizeof(cluster->coneAxis));
+  if (len < 1e-6f)
+    return;
+  for (int k = 0; k < 3; k++)
+    cluster->coneAxis[k] = axis[k] / len;
+  float minDot = 1.0f;
+  for (int t = 0; t < triangles; t++) {
+    const float *n = normals + order[t] * 3;
+    if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+      continue; // degenerate, never rasterised
+    minDot = fminf(minDot, n[0] * cluster->coneAxis[0] +
+                               n[1] * cluster->coneAxis[1] +
+                               n[2] * cluster->coneAxis[2]);
+  }
+  // A half angle of 90 degrees or more faces every direction
+  if (minDot > 0.0f)
+    cluster->coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void MeshCluster_Build(MeshData *data, const char *name) {
+  int levelCount =
+      data->lodCount > 0 ? data->lods[0].indexCount : data->indexCount;
+  int triangleCount = levelCount / 3;
+  if (triangleCount <= MESH_CLUSTER_TRIANGLES)
+    return;
+  const unsigned int *indices = data->indices; // level 0 comes first
+  int vertexCount = data->vertexCount;
+  MeshOptimizeStats before =
+      MeshOptimize_Analyze(indices, levelCount, vertexCount);
+
+  float *normals = (float *)malloc(triangleCount * 3 * sizeof(float));
+  for (int t = 0; t < triangleCount; t++)
+    faceNormal(data->vertices, indices + t * 3, normals + t * 3);
+
+  // Triangles of each vertex
+  int *firstTriangle = (int *)calloc(vertexCount + 1, sizeof(int));
+  int *vertexTriangles = (int *)malloc(levelCount * sizeof(int));
+  for (int i = 0; i < levelCount; i++)
+    firstTriangle[indices[i] + 1]++;
+  for (int v = 0; v < vertexCount; v++)
+    firstTriangle[v + 1] += firstTriangle[v];
+  int *fill = (int *)malloc(vertexCount * sizeof(int));
+  memcpy(fill, firstTriangle, vertexCount * sizeof(int));
+  for (int i = 0; i < levelCount; i++)
+    vertexTriangles[fill[indices[i]]++] = i / 3;
+  free(fill);
+
+  int *owner = (int *)malloc(triangleCount * sizeof(int)); // cluster or -1
+  int *candidateOf = (int *)malloc(triangleCount * sizeof(int));
+  int *vertexOf = (int *)malloc(vertexCount * sizeof(int)); // last cluster
+  int *candidates = (int *)malloc(triangleCount * sizeof(int));
+  int *order = (int *)malloc(triangleCount * sizeof(int));
+  MeshCluster *clusters =
+      (MeshCluster *)malloc(triangleCount * sizeof(MeshCluster));
+  for (int t = 0; t < triangleCount; t++)
+    owner[t] = candidateOf[t] = -1;
+  for (int v = 0; v < vertexCount; v++)
+    vertexOf[v] = -1;
+
+  int emitted = 0, clusterCount = 0, seed = 0;
+  while (emitted < triangleCount) {
+    int id = clusterCount;
+    int start = emitted;
+    int candidateCount = 0;
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    while (owner[seed] >= 0)
+      seed++;
+    int t = seed;
+    for (;;) {
+      owner[t] = id;
+      order[emitted++] = t;
+      for (int k = 0; k < 3; k++)
+        axis[k] += normals[t * 3 + k];
+      for (int k = 0; k < 3; k++) {
+        unsigned int v = indices[t * 3 + k];
+        vertexOf[v] = id;
+        for (int j = firstTriangle[v]; j < firstTriangle[v + 1]; j++) {
+          int u = vertexTriangles[j];
+          if (owner[u] < 0 && candidateOf[u] != id) {
+            candidateOf[u] = id;
+            candidates[candidateCount++] = u;
+          }
+        }
+      }
+      if (emitted - start == MESH_CLUSTER_TRIANGLES ||
+          emitted == triangleCount)
+        break;
+
+      // Most shared vertices first, then the closest facing
+      float len =
+          sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+      float scale = len > 0.0f ? MESH_CLUSTER_CONE_WEIGHT / len : 0.0f;
+      int best = -1;
+      float bestScore = -INFINITY;
+      for (int i = 0; i < candidateCount;) {
+        int u = candidates[i];
+        if (owner[u] >= 0) {
+          candidates[i] = candidates[--candidateCount];
+          continue;
+        }
+        const unsigned int *tri = indices + u * 3;
+        const float *n = normals + u * 3;
+        float score = (float)((vertexOf[tri[0]] == id) +
+                              (vertexOf[tri[1]] == id) +
+                              (vertexOf[tri[2]] == id)) +
+                      scale * (n[0] * axis[0] + n[1] * axis[1] +
+                               n[2] * axis[2]);
+        if (score > bestScore) {
+          bestScore = score;
+          best = i;
+        }
+        i++;
+      }
+      if (best >= 0) {
+        t = candidates[best];
+        candidates[best] = candidates[--candidateCount];
+      } else {
+        // Nothing connected is left; carry on in vertex cache order
+        while (owner[seed] >= 0)
+          seed++;
+        t = seed;
+      }
+    }
+
+    MeshCluster *cluster = &clusters[clusterCount++];
+    cluster->indexOffset = start * 3;
+    cluster->indexCount = (emitted - start) * 3;
+  }
+
+  unsigned int *reordered =
+      (unsigned int *)malloc(levelCount * sizeof(unsigned int));
+  for (int i = 0; i < triangleCount; i++)
+    memcpy(reordered + i * 3, indices + order[i] * 3,
+           3 * sizeof(unsigned int));
+  memcpy(data->indices, reordered, levelCount * sizeof(unsigned int));
+  free(reordered);
+
+  // Growing by connectivity scatters the vertex cache order of the whole
+  // level; every cluster is drawn as a range of its own, so each gets its
+  // own, and the vertices are renumbered for the new order of first use
+  for (int c = 0; c < clusterCount; c++)
+    MeshOptimize_VertexCache(data->indices + clusters[c].indexOffset,
+                             clusters[c].indexCount, vertexCount);
+  data->vertexCount = MeshOptimize_VertexFetch(
+      data->vertices, data->indices, data->indexCount, vertexCount);
+  MeshOptimizeStats after =
+      MeshOptimize_Analyze(data->indices, levelCount, data->vertexCount);
+
+  int coneCount = 0;
+  for (int c = 0; c < clusterCount; c++) {
+    computeBounds(data, normals, order + clusters[c].indexOffset / 3,
+                  &clusters[c]);
+    if (clusters[c].coneCutoff < 1.0f)
+      coneCount++;
+  }
+
+  free(normals);
+  free(firstTriangle);
+  free(vertexTriangles);
+  free(owner);
+  free(candidateOf);
+  free(vertexOf);
+  free(candidates);
+  free(order);
+  data->clusters =
+      (MeshCluster *)realloc(clusters, clusterCount * sizeof(MeshCluster));
+  data->clusterCount = clusterCount;
+  Log_Info("MeshCluster: %s %d clusters, %d with a cone that can cull, "
+           "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+           name, clusterCount, coneCount, before.acmr, after.acmr,
+           before.atvr, after.atvr);
+}
+
+int MeshCluster_Cull(const Mesh *mesh, mat4 model, const Frustum *frustum,
+                     const Occlusion *occlusion, const float eye[3],
+                     int backfaceCulling, GLsizei *counts,
+                     const void **offsets) {
+  const float *m = model.m;
+  float maxScaleSq = 0.0f;
+  for (int col = 0; col < 3; col++) {
+    const float *axis = &m[col * 4];
+    maxScaleSq = fmaxf(maxScaleSq, axis[0] * axis[0] + axis[1] * axis[1] +
+                                       axis[2] * axis[2]);
+  }
+  float worldScale = sqrtf(maxScaleSq);
+
+  // Facing is preserved by affine maps, so the cones are tested in object
+  // space. The inverse of the 3x3 part is the transposed normal matrix.
+  float normal[9];
+  mat4_normal_matrix(model, normal);
+  float d[3] = {eye[0] - m[12], eye[1] - m[13], eye[2] - m[14]};
+  float localEye[3];
+  for (int k = 0; k < 3; k++)
+    localEye[k] = normal[k * 3] * d[0] + normal[k * 3 + 1] * d[1] +
+                  normal[k * 3 + 2] * d[2];
+  // A mirroring model swaps which side is culled; keep such placements
+  float det = m[0] * (m[5] * m[10] - m[6] * m[9]) +
+              m[1] * (m[6] * m[8] - m[4] * m[10]) +
+              m[2] * (m[4] * m[9] - m[5] * m[8]);
+  if (det <= 0.0f)
+    backfaceCulling = 0;
+
+  size_t indexBytes = mesh->indexType == GL_UNSIGNED_SHORT
+                          ? sizeof(uint16_t)
+                          : sizeof(unsigned int);
+  int rangeCount = 0, lastEnd = -1;
+  for (int i = 0; i < mesh->clusterCount; i++) {
+    const MeshCluster *c = &mesh->clusters[i];
+    if (backfaceCulling && c->coneCutoff < 1.0f) {
+      // Every face is back facing when the whole sphere lies within
+      // 90 degrees minus the half angle of the axis, seen from the eye
+      float v[3] = {c->center[0] - localEye[0], c->center[1] - localEye[1],
+                    c->center[2] - localEye[2]};
+      float dist = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+      float along =
+          v[0] * c->coneAxis[0] + v[1] * c->coneAxis[1] + v[2] * c->coneAxis[2];
+      if (along >= c->coneCutoff * dist + c->radius * (1.0f + c->coneCutoff))
+        continue;
+    }
+    float center[3];
+    for (int k = 0; k < 3; k++)
+      center[k] = m[k] * c->center[0] + m[4 + k] * c->center[1] +
+                  m[8 + k] * c->center[2] + m[12 + k];
+    float radius = c->radius * worldScale;
+    if (!Frustum_TestSphere(frustum, center, radius) ||
+        !Occlusion_TestSphere(occlusion, center, radius))
+      continue;
+
+    if (c->indexOffset == lastEnd) {
+      counts[rangeCount - 1] += c->indexCount; // extends the previous range
+    } else {
+      counts[rangeCount] = c->indexCount;
+      offsets[rangeCount] = (const void *)((size_t)c->indexOffset * indexBytes);
+      rangeCount++;
+    }
+    lastEnd = c->indexOffset + c->indexCount;
+  }
+  return rangeCount;
+}
@@ -0,0 +1,30 @@
+#ifndef MESH_CLUSTER_H
+#define MESH_CLUSTER_H
+
+#include "culling.h"
+#include "mesh.h"
+#include "occlusion.h"
+
+// Triangles per cluster; meshes with no more than this are not split
+#define MESH_CLUSTER_TRIANGLES 128
+// Weight of normal agreement against connectivity when growing a cluster;
+// higher gives narrower normal cones at the cost of less compact clusters
+#define MESH_CLUSTER_CONE_WEIGHT 0.5f
+
+// Splits level 0 of data, which must own its buffers, into clusters grown
+// over shared vertices while preferring similar facing, and reorders level
+// 0 so each cluster is a contiguous range optimized for the vertex cache on
+// its own. Renumbers the vertices for the new order. Logs the outcome and
+// the cache statistics before and after under name.
+void MeshCluster_Build(MeshData *data, const char *name);
+// Frustum, occlusion (may be NULL) and, with backfaceCulling, normal cone
+// tests of every cluster of a mesh placed with model as seen from eye.
+// Writes the surviving index ranges for Mesh_DrawRanges to counts and
+// offsets (room for mesh->clusterCount each), merging neighbours, and
+// returns how many there are.
+int MeshCluster_Cull(const Mesh *mesh, mat4 model, const Frustum *frustum,
+                     const Occlusion *occlusion, const float eye[3],
+                     int backfaceCulling, GLsizei *counts,
+                     const void **offsets);
+
+#endif
@@ -0,0 +1,379 @@
+#include "mesh_optimize.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+// FIFO cache simulated with per-vertex timestamps: a vertex is cached while
+// fewer than MESH_OPTIMIZE_FIFO_SIZE misses happened since it was loaded.
+// Start time at MESH_OPTIMIZE_FIFO_SIZE + 1 with zeroed stamps.
+static int fifoMisses(int *stamps, int *time, const unsigned int *triangle) {
+  int misses = 0;
+  for (int k = 0; k < 3; k++) {
+    unsigned int v = triangle[k];
+    if (*time - stamps[v] > MESH_OPTIMIZE_FIFO_SIZE) {
+      stamps[v] = (*time)++;
+      misses++;
+    }
+  }
+  return misses;
+}
+
+MeshOptimizeStats MeshOptimize_Analyze(const unsigned int *indices,
+                                       int indexCount, int vertexCount) {
+  MeshOptimizeStats stats = {0.0f, 0.0f};
+  int triangleCount = indexCount / 3;
+  if (triangleCount == 0)
+    return stats;
+
+  int *stamps = (int *)calloc(vertexCount, sizeof(int));
+  char *referenced = (char *)calloc(vertexCount, 1);
+  int time = MESH_OPTIMIZE_FIFO_SIZE + 1;
+  int misses = 0, unique = 0;
+  for (int t = 0; t < triangleCount; t++)
+    misses += fifoMisses(stamps, &time, indices + t * 3);
+  for (int i = 0; i < indexCount; i++)
+    if (!referenced[indices[i]]) {
+      referenced[indices[i]] = 1;
+      unique++;
+    }
+  free(stamps);
+  free(referenced);
+
+  stats.acmr = (float)misses / (float)triangleCount;
+  stats.atvr = (float)misses / (float)unique;
+  return stats;
+}
+
+static float vertexScore(int cachePosition, int liveTriangles) {
+  if (liveTriangles == 0)
+    return -1.0f; // nothing left to draw with it
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    // The last triangle's vertices get a fixed score, otherwise the next
+    // triangle would too often reuse the same edge
+    if (cachePosition < 3)
+      score = LAST_TRIANGLE_SCORE;
+    else
+      score = powf(1.0f - (float)(cachePosition - 3) /
+                              (MESH_OPTIMIZE_CACHE_SIZE - 3),
+                   CACHE_DECAY_POWER);
+  }
+  // Boost vertices with few triangles left so they do not get stranded
+  score += VALENCE_BOOST_SCALE *
+           powf((float)liveTriangles, -VALENCE_BOOST_POWER);
+  return score;
+}
+
+void MeshOptimize_VertexCache(unsigned int *indices, int indexCount,
+                              int vertexCount) {
+  int triangleCount = indexCount / 3;
+  if (triangleCount <= 0)
+    return;
+
+  // Triangles of each vertex; the first live[v] entries are not emitted yet
+  int *offsets = (int *)calloc(vertexCount + 1, sizeof(int));
+  int *live = (int *)calloc(vertexCount, sizeof(int));
+  int *adjacency = (int *)malloc(indexCount * sizeof(int));
+  for (int i = 0; i < indexCount; i++)
+    offsets[indices[i] + 1]++;
+  for (int v = 0; v < vertexCount; v++)
+    offsets[v + 1] += offsets[v];
+  for (int i = 0; i < indexCount; i++) {
+    unsigned int v = indices[i];
+    adjacency[offsets[v] + live[v]++] = i / 3;
+  }
+
+  int *cachePosition = (int *)malloc(vertexCount * sizeof(int));
+  float *score = (float *)malloc(vertexCount * sizeof(float));
+  for (int v = 0; v < vertexCount; v++) {
+    cachePosition[v] = -1;
+    score[v] = vertexScore(-1, live[v]);
+  }
+
+  float *triangleScore = (float *)malloc(triangleCount * sizeof(float));
+  char *emitted = (char *)calloc(triangleCount, 1);
+  int best = -1;
+  float bestScore = -1.0f;
+  for (int t = 0; t < triangleCount; t++) {
+    const unsigned int *tri = indices + t * 3;
+    triangleScore[t] = score[tri[0]] + score[tri[1]] + score[tri[2]];
+    if (triangleScore[t] > bestScore) {
+      bestScore = triangleScore[t];
+      best = t;
+    }
+  }
+
+  unsigned int *out =
+      (unsigned int *)malloc(indexCount * sizeof(unsigned int));
+  int cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+  int cacheCount = 0;
+  int cursor = 0;
+  for (int n = 0; n < triangleCount; n++) {
+    if (best < 0) {
+      // Dead end: nothing in the cache has triangles left, so continue with
+      // the next one in input order
+      while (emitted[cursor])
+        cursor++;
+      best = cursor;
+    }
+    const unsigned int *tri = indices + best * 3;
+    memcpy(out + n * 3, tri, 3 * sizeof(unsigned int));
+    emitted[best] = 1;
+
+    for (int k = 0; k < 3; k++) {
+      int *list = adjacency + offsets[tri[k]];
+      for (int j = 0; j < live[tri[k]]; j++)
+        if (list[j] == best) {
+          list[j] = list[--live[tri[k]]];
+          break;
+        }
+    }
+
+    // LRU: the triangle's vertices move to the front
+    int next[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    int nextCount = 0;
+    for (int k = 0; k < 3; k++) {
+      int seen = 0;
+      for (int j = 0; j < nextCount; j++)
+        seen |= next[j] == (int)tri[k];
+      if (!seen)
+        next[nextCount++] = (int)tri[k];
+    }
+    for (int i = 0; i < cacheCount; i++) {
+      int v = cache[i];
+      if (v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2])
+        next[nextCount++] = v;
+    }
+
+    // Rescore the cache, including the vertices that just fell out of it,
+    // and pick the best triangle touching it
+    for (int i = 0; i < nextCount; i++) {
+      int v = next[i];
+      cachePosition[v] = i < MESH_OPTIMIZE_CACHE_SIZE ? i : -1;
+      score[v] = vertexScore(cachePosition[v], live[v]);
+    }
+    best = -1;
+    bestScore = -1.0f;
+    for (int i = 0; i < nextCount; i++) {
+      const int *list = adjacency + offsets[next[i]];
+      for (int j = 0; j < live[next[i]]; j++) {
+        int t = list[j];
+        const unsigned int *c = indices + t * 3;
+        triangleScore[t] = score[c[0]] + score[c[1]] + score[c[2]];
+        if (triangleScore[t] > bestScore) {
+          bestScore = triangleScore[t];
+          best = t;
+        }
+      }
+    }
+
+    cacheCount = nextCount < MESH_OPTIMIZE_CACHE_SIZE
+                     ? nextCount
+                     : MESH_OPTIMIZE_CACHE_SIZE;
+    memcpy(cache, next, cacheCount * sizeof(int));
+  }
+
+  memcpy(indices, out, indexCount * sizeof(unsigned int));
+  free(out);
+  free(emitted);
+  free(triangleScore);
+  free(score);
+  free(cachePosition);
+  free(adjacency);
+  free(live);
+  free(offsets);
+}
+
+typedef struct {
+  float key;
+  int cluster;
+} ClusterOrder;
+
+// Most outward facing first; ties keep the cache optimized order
+static int compareClusters(const void *a, const void *b) {
+  const ClusterOrder *ca = (const ClusterOrder *)a;
+  const ClusterOrder *cb = (const ClusterOrder *)b;
+  if (ca->key != cb->key)
+    return ca->key > cb->key ? -1 : 1;
+  return ca->cluster - cb->cluster;
+}
+
+// Returns twice the area; normal is the unnormalized face normal
+static float triangleGeometry(const float *vertices,
+                              const unsigned int *tri, float centroid[3],
+                              float normal[3]) {
+  const float *p0 = vertices + (size_t)tri[0] * MESH_VERTEX_FLOATS;
+  const float *p1 = vertices + (size_t)tri[1] * MESH_VERTEX_FLOATS;
+  const float *p2 = vertices + (size_t)tri[2] * MESH_VERTEX_FLOATS;
+  float e1[3], e2[3];
+  for (int k = 0; k < 3; k++) {
+    e1[k] = p1[k] - p0[k];
+    e2[k] = p2[k] - p0[k];
+    centroid[k] = (p0[k] + p1[k] + p2[k]) / 3.0f;
+  }
+  normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+  return sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+               normal[2] * normal[2]);
+}
+
+void MeshOptimize_Overdraw(unsigned int *indices, int indexCount,
+                           const float *vertices, int vertexCount,
+                           float threshold) {
+  int triangleCount = indexCount / 3;
+  if (triangleCount == 0)
+    return;
+
+  // Hard boundaries: triangles missing all three vertices, where the
+  // cache starts afresh anyway
+  int *hardStart = (int *)malloc((triangleCount + 1) * sizeof(int));
+  int hardCount = 0;
+  int *stamps = (int *)calloc(vertexCount, sizeof(int));
+  int time = MESH_OPTIMIZE_FIFO_SIZE + 1;
+  for (int t = 0; t < triangleCount; t++)
+    if (fifoMisses(stamps, &time, indices + t * 3) == 3 || t == 0)
+      hardStart[hardCount++] = t;
+  hardStart[hardCount] = triangleCount;
+
+  // Soft boundaries split a hard cluster wherever the part so far, drawn
+  // from a cold cache, is within threshold of the whole cluster's ACMR.
+  // Each part then costs about the same wherever it ends up.
+  int *clusterStart = (int *)malloc((triangleCount + 1) * sizeof(int));
+  int clusterCount = 0;
+  for (int h = 0; h < hardCount; h++) {
+    int first = hardStart[h], end = hardStart[h + 1];
+    time += MESH_OPTIMIZE_FIFO_SIZE + 1; // flush
+    int misses = 0;
+    for (int t = first; t < end; t++)
+      misses += fifoMisses(stamps, &time, indices + t * 3);
+    float limit = threshold * (float)misses / (float)(end - first);
+
+    clusterStart[clusterCount++] = first;
+    time += MESH_OPTIMIZE_FIFO_SIZE + 1;
+    misses = 0;
+    int start = first;
+    for (int t = first; t < end - 1; t++) {
+      misses += fifoMisses(stamps, &time, indices + t * 3);
+      if ((float)misses <= limit * (float)(t + 1 - start)) {
+        start = t + 1;
+        clusterStart[clusterCount++] = start;
+        time += MESH_OPTIMIZE_FIFO_SIZE + 1;
+        misses = 0;
+      }
+    }
+  }
+  clusterStart[clusterCount] = triangleCount;
+  free(stamps);
+  free(hardStart);
+
+  // Area weighted centroid and normal per cluster
+  float *clusterData = (float *)calloc(clusterCount * 6, sizeof(float));
+  float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+  float meshArea = 0.0f;
+  for (int c = 0; c < clusterCount; c++) {
+    float *centroid = clusterData + c * 6;
+    float *normal = centroid + 3;
+    float area = 0.0f;
+    for (int t = clusterStart[c]; t < clusterStart[c + 1]; t++) {
+      float tc[3], tn[3];
+      float a = triangleGeometry(vertices, indices + t * 3, tc, tn);
+      for (int k = 0; k < 3; k++) {
+        centroid[k] += tc[k] * a;
+        normal[k] += tn[k];
+      }
+      area += a;
+    }
+    for (int k = 0; k < 3; k++) {
+      meshCentroid[k] += centroid[k];
+      if (area > 0.0f)
+        centroid[k] /= area;
+    }
+    meshArea += area;
+  }
+  for (int k = 0; k < 3; k++)
+    if (meshArea > 0.0f)
+      meshCentroid[k] /= meshArea;
+
+  // Clusters facing away from the middle are likely in front of the rest
+  ClusterOrder *order =
+      (ClusterOrder *)malloc(clusterCount * sizeof(ClusterOrder));
+  for (int c = 0; c < clusterCount; c++) {
+    const float *centroid = clusterData + c * 6;
+    const float *normal = centroid + 3;
+    float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] +
+                         normal[2] * normal[2]);
+    float key = 0.0f;
+    if (length > 0.0f)
+      for (int k = 0; k < 3; k++)
+        key += (centroid[k] - meshCentroid[k]) * normal[k] / length;
+    order[c].key = key;
+    order[c].cluster = c;
+  }
+  qsort(order, clusterCount, sizeof(ClusterOrder), compareClusters);
+
+  unsigned int *out =
+      (unsigned int *)malloc(indexCount * sizeof(unsigned int));
+  int n = 0;
+  for (int i = 0; i < clusterCount; i++) {
+    int c = order[i].cluster;
+    int count = (clusterStart[c + 1] - clusterStart[c]) * 3;
+    memcpy(out + n, indices + clusterStart[c] * 3,
+           count * sizeof(unsigned int));
+    n += count;
+  }
+  memcpy(indices, out, indexCount * sizeof(unsigned int));
+
+  free(out);
+  free(order);
+  free(clusterData);
+  free(clusterStart);
+}
+
+int MeshOptimize_VertexFetch(float *vertices, unsigned int *indices,
+                             int indexCount, int vertexCount) {
+  int *remap = (int *)malloc(vertexCount * sizeof(int));
+  float *ordered = (float *)malloc((size_t)vertexCount * MESH_VERTEX_FLOATS *
+                                   sizeof(float));
+  for (int v = 0; v < vertexCount; v++)
+    remap[v] = -1;
+
+  int next = 0;
+  for (int i = 0; i < indexCount; i++) {
+    unsigned int v = indices[i];
+    if (remap[v] < 0) {
+      remap[v] = next;
+      memcpy(ordered + (size_t)next * MESH_VERTEX_FLOATS,
+             vertices + (size_t)v * MESH_VERTEX_FLOATS,
+             MESH_VERTEX_FLOATS * sizeof(float));
+      next++;
+    }
+    indices[i] = (unsigned int)remap[v];
+  }
+  memcpy(vertices, ordered, (size_t)next * MESH_VERTEX_FLOATS * sizeof(float));
+
+  free(ordered);
+  free(remap);
+  return next;
+}
+
+void MeshOptimize_Run(MeshData *data, const char *name) {
+  MeshOptimizeStats before =
+      MeshOptimize_Analyze(data->indices, data->indexCount, data->vertexCount);
+  MeshOptimize_VertexCache(data->indices, data->indexCount, data->vertexCount);
+  MeshOptimize_Overdraw(data->indices, data->indexCount, data->vertices,
+                        data->vertexCount, MESH_OPTIMIZE_OVERDRAW_THRESHOLD);
+  data->vertexCount = MeshOptimize_VertexFetch(
+      data->vertices, data->indices, data->indexCount, data->vertexCount);
+  MeshOptimizeStats after =
+      MeshOptimize_Analyze(data->indices, data->indexCount, data->vertexCount);
+  Log_Info("MeshOptimize: %s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", name,
+           before.acmr, after.acmr, before.atvr, after.atvr);
+}
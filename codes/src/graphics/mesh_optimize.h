@@ -0,0 +1,39 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include "mesh.h"
+
+// Post-transform cache modelled by the optimizer (LRU, Forsyth's scoring)
+#define MESH_OPTIMIZE_CACHE_SIZE 32
+// FIFO cache used for the reported statistics, a typical hardware size
+#define MESH_OPTIMIZE_FIFO_SIZE 16
+// Overdraw ordering may raise ACMR by up to this factor
+#define MESH_OPTIMIZE_OVERDRAW_THRESHOLD 1.05f
+
+typedef struct {
+  float acmr; // vertex shader runs per triangle (0.5 ideal, 3 worst)
+  float atvr; // vertex shader runs per referenced vertex (1 ideal)
+} MeshOptimizeStats;
+
+// Triangle lists only. Everything works in place on CPU data and does not
+// touch GL, so it can run on a loader thread.
+
+MeshOptimizeStats MeshOptimize_Analyze(const unsigned int *indices,
+                                       int indexCount, int vertexCount);
+// Reorders triangles for the post-transform cache (Forsyth)
+void MeshOptimize_VertexCache(unsigned int *indices, int indexCount,
+                              int vertexCount);
+// Reorders clusters of an already cache optimized list so outward facing
+// surfaces come first (Sander et al.), trading at most threshold * ACMR
+void MeshOptimize_Overdraw(unsigned int *indices, int indexCount,
+                           const float *vertices, int vertexCount,
+                           float threshold);
+// Renumbers vertices in order of first use, dropping unreferenced ones.
+// Returns the new vertex count.
+int MeshOptimize_VertexFetch(float *vertices, unsigned int *indices,
+                             int indexCount, int vertexCount);
+// All three passes in order on data that owns its buffers, logging the
+// statistics before and after under name
+void MeshOptimize_Run(MeshData *data, const char *name);
+
+#endif
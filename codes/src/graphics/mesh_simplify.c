@@ -0,0 +1,379 @@
+#include "mesh_simplify.h"
+#include "mesh_optimize.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Border planes weigh this much more than faces, so open edges keep their
+// outline
+#define BORDER_WEIGHT 10.0
+// Collapses that turn a remaining triangle by more than ~80 degrees are
+// rejected as folds
+#define FLIP_COS_LIMIT 0.2f
+
+// Sum of squared distances to a set of weighted planes
+typedef struct {
+  double a00, a01, a02, a11, a12, a22; // symmetric 3x3
+  double b0, b1, b2;
+  double c;
+  double weight;
+} Quadric;
+
+static void quadricAddPlane(Quadric *q, const double n[3], double d,
+                            double w) {
+  q->a00 += w * n[0] * n[0];
+  q->a01 += w * n[0] * n[1];
+  q->a02 += w * n[0] * n[2];
+  q->a11 += w * n[1] * n[1];
+  q->a12 += w * n[1] * n[2];
+  q->a22 += w * n[2] * n[2];
+  q->b0 += w * n[0] * d;
+  q->b1 += w * n[1] * d;
+  q->b2 += w * n[2] * d;
+  q->c += w * d * d;
+  q->weight += w;
+}
+
+static void quadricAdd(Quadric *q, const Quadric *o) {
+  q->a00 += o->a00;
+  q->a01 += o->a01;
+  q->a02 += o->a02;
+  q->a11 += o->a11;
+  q->a12 += o->a12;
+  q->a22 += o->a22;
+  q->b0 += o->b0;
+  q->b1 += o->b1;
+  q->b2 += o->b2;
+  q->c += o->c;
+  q->weight += o->weight;
+}
+
+static double quadricError(const Quadric *q, const float *p) {
+  double x = p[0], y = p[1], z = p[2];
+  double e = q->a00 * x * x + q->a11 * y * y + q->a22 * z * z +
+             2.0 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z) +
+             2.0 * (q->b0 * x + q->b1 * y + q->b2 * z) + q->c;
+  return e > 0.0 ? e : 0.0;
+}
+
+static const float *position(const float *vertices, unsigned int v) {
+  return vertices + (size_t)v * MESH_VERTEX_FLOATS;
+}
+
+static void triangleNormal(const float *p0, const float *p1, const float *p2,
+                           double n[3]) {
+  double e1[3], e2[3];
+  for (int k = 0; k < 3; k++) {
+    e1[k] = p1[k] - p0[k];
+    e2[k] = p2[k] - p0[k];
+  }
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// Lowest vertex index at the same position, so seams and borders are
+// found by position rather than by the welded (position, UV, normal)
+// vertex
+static int *positionGroups(const float *vertices, int vertexCount) {
+  unsigned int cap = 64;
+  while (cap < (unsigned int)vertexCount * 2)
+    cap <<= 1;
+  int *slots = (int *)malloc(cap * sizeof(int));
+  for (unsigned int i = 0; i < cap; i++)
+    slots[i] = -1;
+  int *group = (int *)malloc(vertexCount * sizeof(int));
+  for (int v = 0; v < vertexCount; v++) {
+    const float *p = position(vertices, v);
+    uint32_t bits[3];
+    memcpy(bits, p, sizeof(bits));
+    uint32_t h = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^
+                 (bits[2] * 83492791u);
+    unsigned int slot = h & (cap - 1);
+    while (slots[slot] >= 0 &&
+           memcmp(position(vertices, slots[slot]), p, 3 * sizeof(float)))
+      slot = (slot + 1) & (cap - 1);
+    if (slots[slot] < 0)
+      slots[slot] = v;
+    group[v] = slots[slot];
+  }
+  free(slots);
+  return group;
+}
+
+typedef struct {
+  uint64_t key; // lower group << 32 | higher group
+  int triangle;
+  int corner; // edge from corner to corner + 1
+} EdgeRef;
+
+static int compareEdges(const void *a, const void *b) {
+  uint64_t ka = ((const EdgeRef *)a)->key;
+  uint64_t kb = ((const EdgeRef *)b)->key;
+  return (ka > kb) - (ka < kb);
+}
+
+// Planes through each open edge, perpendicular to its face
+static void addBorderQuadrics(const unsigned int *indices, int indexCount,
+                              const float *vertices, const int *group,
+                              Quadric *quadrics) {
+  EdgeRef *edges = (EdgeRef *)malloc(indexCount * sizeof(EdgeRef));
+  for (int i = 0; i < indexCount; i++) {
+    int t = i / 3, k = i % 3;
+    uint64_t a = (uint64_t)group[indices[i]];
+    uint64_t b = (uint64_t)group[indices[t * 3 + (k + 1) % 3]];
+    edges[i].key = a < b ? a << 32 | b : b << 32 | a;
+    edges[i].triangle = t;
+    edges[i].corner = k;
+  }
+  qsort(edges, indexCount, sizeof(EdgeRef), compareEdges);
+
+  for (int i = 0; i < indexCount;) {
+    int run = 1;
+    while (i + run < indexCount && edges[i + run].key == edges[i].key)
+      run++;
+    if (run == 1) {
+      const unsigned int *tri = indices + edges[i].triangle * 3;
+      unsigned int v0 = tri[edges[i].corner];
+      unsigned int v1 = tri[(edges[i].corner + 1) % 3];
+      const float *p0 = position(vertices, v0);
+      const float *p1 = position(vertices, v1);
+      double n[3], e[3], b[3];
+      triangleNormal(p0, p1, position(vertices, tri[(edges[i].corner + 2) % 3]),
+                     n);
+      for (int k = 0; k < 3; k++)
+        e[k] = p1[k] - p0[k];
+      b[0] = e[1] * n[2] - e[2] * n[1];
+      b[1] = e[2] * n[0] - e[0] * n[2];
+      b[2] = e[0] * n[1] - e[1] * n[0];
+      double length = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+      if (length > 0.0) {
+        for (int k = 0; k < 3; k++)
+          b[k] /= length;
+        double d = -(b[0] * p0[0] + b[1] * p0[1] + b[2] * p0[2]);
+        double w = BORDER_WEIGHT * (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+        quadricAddPlane(&quadrics[v0], b, d, w);
+        quadricAddPlane(&quadrics[v1], b, d, w);
+      }
+    }
+    i += run;
+  }
+  free(edges);
+}
+
+typedef struct {
+  float cost;
+  unsigned int from, to;
+} Collapse;
+
+static int compareCollapses(const void *a, const void *b) {
+  float ca = ((const Collapse *)a)->cost;
+  float cb = ((const Collapse *)b)->cost;
+  return (ca > cb) - (ca < cb);
+}
+
+// Whether moving from onto to folds any triangle that survives the collapse
+static int collapseFolds(const unsigned int *indices, const int *triangles,
+                         int count, const float *vertices, unsigned int from,
+                         unsigned int to) {
+  for (int i = 0; i < count; i++) {
+    const unsigned int *tri = indices + triangles[i] * 3;
+    if (tri[0] == to || tri[1] == to || tri[2] == to)
+      continue; // degenerates and is removed
+    const float *p[3], *q[3];
+    for (int k = 0; k < 3; k++) {
+      p[k] = position(vertices, tri[k]);
+      q[k] = tri[k] == from ? position(vertices, to) : p[k];
+    }
+    double before[3], after[3];
+    triangleNormal(p[0], p[1], p[2], before);
+    triangleNormal(q[0], q[1], q[2], after);
+    double dotBA = before[0] * after[0] + before[1] * after[1] +
+                   before[2] * after[2];
+    double lengths =
+        sqrt((before[0] * before[0] + before[1] * before[1] +
+              before[2] * before[2]) *
+             (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+    if (dotBA <= FLIP_COS_LIMIT * lengths)
+      return 1;
+  }
+  return 0;
+}
+
+int MeshSimplify_Simplify(unsigned int *indices, int indexCount,
+                          const float *vertices, int vertexCount,
+                          int targetIndexCount, float *error) {
+  *error = 0.0f;
+  if (indexCount <= targetIndexCount)
+    return indexCount;
+
+  int *group = positionGroups(vertices, vertexCount);
+  // Vertices sharing their position with another are on an attribute seam;
+  // collapsing one side would tear the surface open
+  char *locked = (char *)calloc(vertexCount, 1);
+  for (int v = 0; v < vertexCount; v++)
+    if (group[v] != v)
+      locked[v] = locked[group[v]] = 1;
+
+  // Face planes weighted by area
+  Quadric *quadrics = (Quadric *)calloc(vertexCount, sizeof(Quadric));
+  for (int t = 0; t < indexCount / 3; t++) {
+    const unsigned int *tri = indices + t * 3;
+    const float *p0 = position(vertices, tri[0]);
+    double n[3];
+    triangleNormal(p0, position(vertices, tri[1]), position(vertices, tri[2]),
+                   n);
+    double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length <= 0.0)
+      continue;
+    for (int k = 0; k < 3; k++)
+      n[k] /= length;
+    double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+    for (int k = 0; k < 3; k++)
+      quadricAddPlane(&quadrics[tri[k]], n, d, 0.5 * length);
+  }
+  addBorderQuadrics(indices, indexCount, vertices, group, quadrics);
+  free(group);
+
+  int *offsets = (int *)malloc((vertexCount + 1) * sizeof(int));
+  int *adjacency = (int *)malloc(indexCount * sizeof(int));
+  int *fill = (int *)malloc(vertexCount * sizeof(int));
+  char *touched = (char *)malloc(vertexCount);
+  unsigned int *remap = (unsigned int *)malloc(vertexCount * sizeof(int));
+  // Both directions of every triangle edge
+  Collapse *collapses =
+      (Collapse *)malloc(2 * (size_t)indexCount * sizeof(Collapse));
+  float maxError = 0.0f;
+
+  // Each pass collapses an independent set of the cheapest edges, so no
+  // two collapses in a pass touch the same triangle
+  while (indexCount > targetIndexCount) {
+    memset(offsets, 0, (vertexCount + 1) * sizeof(int));
+    for (int i = 0; i < indexCount; i++)
+      offsets[indices[i] + 1]++;
+    for (int v = 0; v < vertexCount; v++)
+      offsets[v + 1] += offsets[v];
+    memcpy(fill, offsets, vertexCount * sizeof(int));
+    for (int i = 0; i < indexCount; i++)
+      adjacency[fill[indices[i]]++] = i / 3;
+
+    int candidates = 0;
+    for (int i = 0; i < indexCount; i++) {
+      unsigned int a = indices[i];
+      unsigned int b = indices[(i / 3) * 3 + (i % 3 + 1) % 3];
+      for (int dir = 0; dir < 2; dir++) {
+        unsigned int from = dir ? b : a, to = dir ? a : b;
+        if (locked[from] || from == to)
+          continue;
+        Quadric q = quadrics[from];
+        quadricAdd(&q, &quadrics[to]);
+        Collapse *c = &collapses[candidates++];
+        c->cost = (float)(quadricError(&q, position(vertices, to)) /
+                          (q.weight > 0.0 ? q.weight : 1.0));
+        c->from = from;
+        c->to = to;
+      }
+    }
+    qsort(collapses, candidates, sizeof(Collapse), compareCollapses);
+
+    // About two triangles go per collapse
+    int budget = (indexCount - targetIndexCount) / 6 + 1;
+    int done = 0;
+    memset(touched, 0, vertexCount);
+    for (int v = 0; v < vertexCount; v++)
+      remap[v] = (unsigned int)v;
+    for (int i = 0; i < candidates && done < budget; i++) {
+      unsigned int from = collapses[i].from, to = collapses[i].to;
+      if (touched[from] || touched[to])
+        continue;
+      const int *triangles = adjacency + offsets[from];
+      int count = offsets[from + 1] - offsets[from];
+      if (collapseFolds(indices, triangles, count, vertices, from, to))
+        continue;
+
+      remap[from] = to;
+      quadricAdd(&quadrics[to], &quadrics[from]);
+      if (collapses[i].cost > maxError)
+        maxError = collapses[i].cost;
+      for (int j = 0; j < count; j++)
+        for (int k = 0; k < 3; k++)
+          touched[indices[triangles[j] * 3 + k]] = 1;
+      done++;
+    }
+    if (done == 0)
+      break;
+
+    int out = 0;
+    for (int i = 0; i < indexCount; i += 3) {
+      unsigned int a = remap[indices[i]];
+      unsigned int b = remap[indices[i + 1]];
+      unsigned int c = remap[indices[i + 2]];
+      if (a == b || b == c || c == a)
+        continue;
+      indices[out++] = a;
+      indices[out++] = b;
+      indices[out++] = c;
+    }
+    indexCount = out;
+  }
+
+  free(collapses);
+  free(remap);
+  free(touched);
+  free(fill);
+  free(adjacency);
+  free(offsets);
+  free(quadrics);
+  free(locked);
+  // Costs are mean squared distances
+  *error = sqrtf(maxError);
+  return indexCount;
+}
+
+void MeshSimplify_BuildLods(MeshData *data, const char *name) {
+  // Room for every level at full size, trimmed once the chain is known
+  unsigned int *indices = (unsigned int *)malloc(
+      MESH_MAX_LODS * (size_t)data->indexCount * sizeof(unsigned int));
+  memcpy(indices, data->indices, data->indexCount * sizeof(unsigned int));
+  data->lods[0].indexOffset = 0;
+  data->lods[0].indexCount = data->indexCount;
+  data->lods[0].error = 0.0f;
+  data->lodCount = 1;
+
+  int end = data->indexCount;
+  char summary[128];
+  int written = snprintf(summary, sizeof(summary), "%d", data->indexCount / 3);
+  while (data->lodCount < MESH_MAX_LODS) {
+    const MeshLod *prev = &data->lods[data->lodCount - 1];
+    unsigned int *level = indices + end;
+    memcpy(level, indices + prev->indexOffset,
+           prev->indexCount * sizeof(unsigned int));
+    int target =
+        (int)(prev->indexCount / 3 * MESH_SIMPLIFY_LEVEL_RATIO) * 3;
+    float error;
+    int count = MeshSimplify_Simplify(level, prev->indexCount, data->vertices,
+                                      data->vertexCount, target, &error);
+    if (count > prev->indexCount * MESH_SIMPLIFY_MIN_REDUCTION)
+      break;
+    MeshOptimize_VertexCache(level, count, data->vertexCount);
+
+    MeshLod *lod = &data->lods[data->lodCount++];
+    lod->indexOffset = end;
+    lod->indexCount = count;
+    // Each level was simplified from the previous one
+    lod->error = prev->error + error;
+    end += count;
+    if (written < (int)sizeof(summary))
+      written += snprintf(summary + written, sizeof(summary) - written,
+                          " / %d (%.4f)", count / 3, lod->error);
+  }
+
+  free(data->indices);
+  data->indices =
+      (unsigned int *)realloc(indices, end * sizeof(unsigned int));
+  data->indexCount = end;
+  Log_Info("MeshSimplify: %s triangles (error) %s", name, summary);
+}
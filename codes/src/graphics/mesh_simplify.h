@@ -0,0 +1,24 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include "mesh.h"
+
+// Each level aims for this fraction of the previous level's triangles
+#define MESH_SIMPLIFY_LEVEL_RATIO 0.5f
+// A level that cannot get below this fraction of the previous one is not
+// worth its draw and ends the chain
+#define MESH_SIMPLIFY_MIN_REDUCTION 0.8f
+
+// Quadric error edge collapse (Garland & Heckbert) onto existing vertices,
+// so a simplified level only needs a new index list over the same vertex
+// buffer. Vertices on UV/normal seams stay put; open borders may slide
+// along themselves. Returns the new index count (at most indexCount) and
+// stores the largest collapse error, an object space distance, in *error.
+int MeshSimplify_Simplify(unsigned int *indices, int indexCount,
+                          const float *vertices, int vertexCount,
+                          int targetIndexCount, float *error);
+// Appends up to MESH_MAX_LODS - 1 coarser levels to data, which must own
+// its buffers, and logs the triangle count of each level under name
+void MeshSimplify_BuildLods(MeshData *data, const char *name);
+
+#endif
@@ -0,0 +1,168 @@
+#include "occlusion.h"
+#include "gl_state.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void Occlusion_Init(Occlusion *occlusion, GLuint program) {
+  memset(occlusion, 0, sizeof(Occlusion));
+  occlusion->program = program;
+  occlusion->model = Shader_GetUniform(program, "model");
+
+  glGenFramebuffers(1, &occlusion->frameBuffer);
+  GLState_BindFramebuffer(occlusion->frameBuffer);
+  glGenRenderbuffers(1, &occlusion->depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, occlusion->depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+                        OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, occlusion->depthBuffer);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    Log_Error("Occlusion: depth framebuffer is not complete");
+  GLState_BindFramebuffer(0);
+
+  occlusion->depth =
+      (float *)malloc(OCCLUSION_WIDTH * OCCLUSION_HEIGHT * sizeof(float));
+  int w = OCCLUSION_WIDTH, h = OCCLUSION_HEIGHT;
+  for (int level = 0; level < OCCLUSION_MAX_LEVELS; level++) {
+    occlusion->levels[level] = (float *)malloc(w * h * sizeof(float));
+    occlusion->levelWidth[level] = w;
+    occlusion->levelHeight[level] = h;
+    occlusion->levelCount++;
+    if (w == 1 && h == 1)
+      break;
+    w = w > 1 ? w / 2 : 1;
+    h = h > 1 ? h / 2 : 1;
+  }
+}
+
+void Occlusion_Begin(Occlusion *occlusion, mat4 viewProjection) {
+  memcpy(occlusion->viewProjection, viewProjection.m,
+         sizeof(occlusion->viewProjection));
+  occlusion->ready = 0;
+  occlusion->savedFramebuffer = GLState_GetFramebuffer();
+  GLState_GetViewport(occlusion->savedViewport);
+
+  GLState_BindFramebuffer(occlusion->frameBuffer);
+  GLState_Viewport(0, 0, OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+  GLState_DepthMask(GL_TRUE);
+  glClear(GL_DEPTH_BUFFER_BIT);
+  Shader_Use(occlusion->program);
+}
+
+void Occlusion_AddOccluder(Occlusion *occlusion, Mesh *mesh, mat4 model) {
+  if (mesh->indexCount == 0)
+    return; // not loaded
+  mat4 position = Mesh_PositionMatrix(mesh, model);
+  Shader_UniformMat4(occlusion->model, position.m);
+  Mesh_Draw(mesh);
+}
+
+// Level 0 keeps the farthest depth of each texel's 3x3 neighbourhood: the
+// readback only samples texel centres, and an occluder edge crossing a
+// texel must not hide what shows through the rest of it
+static void buildBaseLevel(Occlusion *occlusion) {
+  const float *src = occlusion->depth;
+  float *dst = occlusion->levels[0];
+  int w = OCCLUSION_WIDTH, h = OCCLUSION_HEIGHT;
+  for (int y = 0; y < h; y++) {
+    int y0 = y > 0 ? y - 1 : 0, y1 = y < h - 1 ? y + 1 : h - 1;
+    for (int x = 0; x < w; x++) {
+      int x0 = x > 0 ? x - 1 : 0, x1 = x < w - 1 ? x + 1 : w - 1;
+      float farthest = 0.0f;
+      for (int sy = y0; sy <= y1; sy++)
+        for (int sx = x0; sx <= x1; sx++)
+          farthest = fmaxf(farthest, src[sy * w + sx]);
+      dst[y * w + x] = farthest;
+    }
+  }
+}
+
+static void buildLevel(Occlusion *occlusion, int level) {
+  const float *src = occlusion->levels[level - 1];
+  float *dst = occlusion->levels[level];
+  int srcW = occlusion->levelWidth[level - 1];
+  int srcH = occlusion->levelHeight[level - 1];
+  int w = occlusion->levelWidth[level], h = occlusion->levelHeight[level];
+  for (int y = 0; y < h; y++) {
+    int y0 = 2 * y, y1 = 2 * y + 1 < srcH ? 2 * y + 1 : srcH - 1;
+    for (int x = 0; x < w; x++) {
+      int x0 = 2 * x, x1 = 2 * x + 1 < srcW ? 2 * x + 1 : srcW - 1;
+      dst[y * w + x] = fmaxf(fmaxf(src[y0 * srcW + x0], src[y0 * srcW + x1]),
+                             fmaxf(src[y1 * srcW + x0], src[y1 * srcW + x1]));
+    }
+  }
+}
+
+void Occlusion_End(Occlusion *occlusion) {
+  glReadPixels(0, 0, OCCLUSION_WIDTH, OCCLUSION_HEIGHT, GL_DEPTH_COMPONENT,
+               GL_FLOAT, occlusion->depth);
+  buildBaseLevel(occlusion);
+  for (int level = 1; level < occlusion->levelCount; level++)
+    buildLevel(occlusion, level);
+  occlusion->ready = 1;
+
+  GLState_BindFramebuffer(occlusion->savedFramebuffer);
+  GLState_Viewport(occlusion->savedViewport[0], occlusion->savedViewport[1],
+                   occlusion->savedViewport[2], occlusion->savedViewport[3]);
+}
+
+int Occlusion_TestSphere(const Occlusion *occlusion, const float center[3],
+                         float radius) {
+  if (!occlusion || !occlusion->ready)
+    return 1;
+
+  // Screen rectangle and nearest depth of the box around the sphere, which
+  // bound those of the sphere itself
+  const float *m = occlusion->viewProjection;
+  float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+  float nearest = 1.0f;
+  for (int i = 0; i < 8; i++) {
+    float p[3] = {center[0] + (i & 1 ? radius : -radius),
+                  center[1] + (i & 2 ? radius : -radius),
+                  center[2] + (i & 4 ? radius : -radius)};
+    float clip[4];
+    for (int k = 0; k < 4; k++)
+      clip[k] = m[k] * p[0] + m[4 + k] * p[1] + m[8 + k] * p[2] + m[12 + k];
+    if (clip[3] <= 1e-4f)
+      return 1; // reaches behind the eye
+    float x = clip[0] / clip[3], y = clip[1] / clip[3];
+    minX = fminf(minX, x);
+    maxX = fmaxf(maxX, x);
+    minY = fminf(minY, y);
+    maxY = fmaxf(maxY, y);
+    nearest = fminf(nearest, clip[2] / clip[3] * 0.5f + 0.5f);
+  }
+  if (nearest <= 0.0f)
+    return 1;
+
+  // Texel range on level 0, clamped to the screen (the frustum test owns
+  // what lies outside it)
+  int x0 = (int)floorf(fmaxf(minX * 0.5f + 0.5f, 0.0f) * OCCLUSION_WIDTH);
+  int y0 = (int)floorf(fmaxf(minY * 0.5f + 0.5f, 0.0f) * OCCLUSION_HEIGHT);
+  int x1 = (int)floorf(fminf(maxX * 0.5f + 0.5f, 1.0f) * OCCLUSION_WIDTH);
+  int y1 = (int)floorf(fminf(maxY * 0.5f + 0.5f, 1.0f) * OCCLUSION_HEIGHT);
+  if (x1 >= OCCLUSION_WIDTH)
+    x1 = OCCLUSION_WIDTH - 1;
+  if (y1 >= OCCLUSION_HEIGHT)
+    y1 = OCCLUSION_HEIGHT - 1;
+  if (x0 > x1 || y0 > y1)
+    return 1;
+
+  // Coarsest level needed to cover the rectangle with a few texels
+  int level = 0;
+  while (level < occlusion->levelCount - 1 &&
+         ((x1 >> level) - (x0 >> level) > 2 ||
+          (y1 >> level) - (y0 >> level) > 2))
+    level++;
+  const float *depth = occlusion->levels[level];
+  int w = occlusion->levelWidth[level];
+  for (int y = y0 >> level; y <= y1 >> level; y++)
+    for (int x = x0 >> level; x <= x1 >> level; x++)
+      if (nearest <= depth[y * w + x])
+        return 1;
+  return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "../utils/math_utils.h"
+#include "mesh.h"
+#include "shader.h"
+
+// Resolution the occluders are rasterised at; powers of two so every
+// pyramid level halves exactly
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define OCCLUSION_MAX_LEVELS 9 // down to 1x1
+
+// Hierarchical Z occlusion culling. Each pass first rasterises a few big
+// occluders into a small depth buffer, reads it back (GL 3.3 has no
+// compute, and the pass needs the answers on the CPU anyway) and reduces it
+// into a pyramid of farthest depths. Bounding spheres are then rejected
+// when their nearest depth lies behind every texel they cover.
+typedef struct {
+  GLuint frameBuffer;
+  GLuint depthBuffer;
+  GLuint program;
+  ShaderUniform model;
+  float viewProjection[16];
+  float *depth; // readback scratch
+  // Window space depth [0, 1] of the farthest occluder within each texel
+  float *levels[OCCLUSION_MAX_LEVELS];
+  int levelWidth[OCCLUSION_MAX_LEVELS];
+  int levelHeight[OCCLUSION_MAX_LEVELS];
+  int levelCount;
+  int ready; // a pyramid exists for the current pass
+  GLuint savedFramebuffer;
+  GLint savedViewport[4];
+} Occlusion;
+
+// program is occluder.vert/occluder.frag with the Camera block bound
+void Occlusion_Init(Occlusion *occlusion, GLuint program);
+// Starts the occluder depth pass; the Camera block must already hold the
+// pass's view and projection, and viewProjection must be their product
+void Occlusion_Begin(Occlusion *occlusion, mat4 viewProjection);
+void Occlusion_AddOccluder(Occlusion *occlusion, Mesh *mesh, mat4 model);
+// Reads the depth back, builds the pyramid and restores the framebuffer
+// and viewport that were bound at Begin
+void Occlusion_End(Occlusion *occlusion);
+// 0 only when the world space sphere is certainly hidden; a NULL
+// occlusion or one without a pyramid keeps everything
+int Occlusion_TestSphere(const Occlusion *occlusion, const float center[3],
+                         float radius);
+
+#endif
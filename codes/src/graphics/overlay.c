@@ -0,0 +1,311 @@
+#include "overlay.h"
+#include "gl_state.h"
+#include "profiler.h"
+#include "render_stats.h"
+#include "shader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_IMPLEMENTATION
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#include "../../libs/glfw/deps/nuklear.h"
+#pragma GCC diagnostic pop
+
+#define OVERLAY_MAX_VERTEX_BYTES (512 * 1024)
+#define OVERLAY_MAX_INDEX_BYTES (128 * 1024)
+
+// Not in every glext.h; both report kilobytes
+#define OVERLAY_GPU_MEMORY_TOTAL_NVX 0x9048
+#define OVERLAY_GPU_MEMORY_AVAILABLE_NVX 0x9049
+#define OVERLAY_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+typedef struct {
+  float position[2];
+  float uv[2];
+  nk_byte color[4];
+} OverlayVertex;
+
+typedef struct {
+  struct nk_context ctx;
+  struct nk_font_atlas atlas;
+  struct nk_draw_null_texture nullTexture;
+  struct nk_buffer commands;
+  GLuint program;
+  ShaderUniform orthoProjection;
+  ShaderUniform atlasSampler;
+  GLuint fontTexture;
+  GLuint VAO, VBO, EBO;
+  void *vertices;
+  void *indices;
+  int memoryQuery; // 0 none, 1 NVX, 2 ATI
+} OverlayState;
+
+static OverlayState *overlay = NULL;
+static int visible = 0;
+static int toggleHeld = 0;
+
+static float history[OVERLAY_HISTORY];
+static int historyCount = 0;
+static int historyHead = 0;
+static ShaderStats lastShaderStats;
+static GLStateStats lastStateStats;
+
+static int hasExtension(const char *name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++) {
+    const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+    if (ext && strcmp(ext, name) == 0)
+      return 1;
+  }
+  return 0;
+}
+
+static void overlayInit(void) {
+  overlay = (OverlayState *)calloc(1, sizeof(OverlayState));
+  nk_init_default(&overlay->ctx, NULL);
+  nk_buffer_init_default(&overlay->commands);
+
+  // Bake the built-in font and keep its white pixel for untextured shapes
+  int atlasWidth, atlasHeight;
+  nk_font_atlas_init_default(&overlay->atlas);
+  nk_font_atlas_begin(&overlay->atlas);
+  struct nk_font *font = nk_font_atlas_add_default(&overlay->atlas, 13.0f, 0);
+  const void *image = nk_font_atlas_bake(&overlay->atlas, &atlasWidth,
+                                         &atlasHeight, NK_FONT_ATLAS_RGBA32);
+  glGenTextures(1, &overlay->fontTexture);
+  GLState_BindTexture(0, overlay->fontTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, image);
+  nk_font_atlas_end(&overlay->atlas, nk_handle_id((int)overlay->fontTexture),
+                    &overlay->nullTexture);
+  nk_style_set_font(&overlay->ctx, &font->handle);
+
+  overlay->program =
+      Shader_Create("shaders/overlay.vert", "shaders/overlay.frag");
+  overlay->orthoProjection =
+      Shader_GetUniform(overlay->program, "orthoProjection");
+  overlay->atlasSampler = Shader_GetUniform(overlay->program, "atlas");
+
+  glGenVertexArrays(1, &overlay->VAO);
+  glGenBuffers(1, &overlay->VBO);
+  glGenBuffers(1, &overlay->EBO);
+  GLState_BindVertexArray(overlay->VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, overlay->VBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, overlay->EBO);
+  GLsizei stride = sizeof(OverlayVertex);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride,
+                        (void *)offsetof(OverlayVertex, position));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+                        (void *)offsetof(OverlayVertex, uv));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                        (void *)offsetof(OverlayVertex, color));
+  glEnableVertexAttribArray(2);
+  GLState_BindVertexArray(0);
+
+  overlay->vertices = malloc(OVERLAY_MAX_VERTEX_BYTES);
+  overlay->indices = malloc(OVERLAY_MAX_INDEX_BYTES);
+
+  if (hasExtension("GL_NVX_gpu_memory_info"))
+    overlay->memoryQuery = 1;
+  else if (hasExtension("GL_ATI_meminfo"))
+    overlay->memoryQuery = 2;
+}
+
+void Overlay_HandleInput(GLFWwindow *window) {
+  int pressed = glfwGetKey(window, OVERLAY_TOGGLE_KEY) == GLFW_PRESS;
+  if (pressed && !toggleHeld) {
+    visible = !visible;
+    if (visible) {
+      // Start the graph fresh; nothing is recorded while hidden
+      historyCount = 0;
+      historyHead = 0;
+      lastShaderStats = Shader_GetStats();
+      lastStateStats = GLState_GetStats();
+    }
+  }
+  toggleHeld = pressed;
+}
+
+int Overlay_IsVisible(void) { return visible; }
+
+static void pushHistory(float frameMs) {
+  history[historyHead] = frameMs;
+  historyHead = (historyHead + 1) % OVERLAY_HISTORY;
+  if (historyCount < OVERLAY_HISTORY)
+    historyCount++;
+}
+
+static void buildUI(struct nk_context *ctx, int height, float frameMs) {
+  if (!nk_begin(ctx, "Performance", nk_rect(10, 10, 330, height - 20.0f),
+                NK_WINDOW_BORDER | NK_WINDOW_TITLE | NK_WINDOW_NO_INPUT))
+    goto done;
+
+  // Frame time graph, oldest sample first
+  float maxMs = 1.0f;
+  for (int i = 0; i < historyCount; i++)
+    if (history[i] > maxMs)
+      maxMs = history[i];
+  nk_layout_row_dynamic(ctx, 16, 1);
+  nk_labelf(ctx, NK_TEXT_LEFT, "Frame %.2f ms (%.0f fps), graph max %.1f ms",
+            frameMs, frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, maxMs);
+  nk_layout_row_dynamic(ctx, 70, 1);
+  if (nk_chart_begin(ctx, NK_CHART_LINES, historyCount, 0.0f, maxMs)) {
+    int start = historyCount < OVERLAY_HISTORY ? 0 : historyHead;
+    for (int i = 0; i < historyCount; i++)
+      nk_chart_push(ctx, history[(start + i) % OVERLAY_HISTORY]);
+    nk_chart_end(ctx);
+  }
+
+  // Counters for the frame just rendered
+  RenderStats stats = RenderStats_Get();
+  ShaderStats shaderStats = Shader_GetStats();
+  GLStateStats stateStats = GLState_GetStats();
+  nk_layout_row_dynamic(ctx, 16, 1);
+  nk_labelf(ctx, NK_TEXT_LEFT, "Draw calls: %d  Triangles: %d",
+            stats.drawCalls, stats.triangles);
+  nk_labelf(ctx, NK_TEXT_LEFT, "Instances: %d visible, %d culled",
+            stats.visible, stats.culled);
+  nk_labelf(ctx, NK_TEXT_LEFT, "Occluded (Hi-Z): %d", stats.occluded);
+  nk_labelf(ctx, NK_TEXT_LEFT, "Uniform uploads: %d (%d filtered)",
+            shaderStats.uploads - lastShaderStats.uploads,
+            shaderStats.filtered - lastShaderStats.filtered);
+  nk_labelf(ctx, NK_TEXT_LEFT, "GL state calls: %d (%d filtered)",
+            stateStats.issued - lastStateStats.issued,
+            stateStats.filtered - lastStateStats.filtered);
+
+  if (overlay->memoryQuery == 1) {
+    GLint totalKB = 0, availableKB = 0;
+    glGetIntegerv(OVERLAY_GPU_MEMORY_TOTAL_NVX, &totalKB);
+    glGetIntegerv(OVERLAY_GPU_MEMORY_AVAILABLE_NVX, &availableKB);
+    nk_labelf(ctx, NK_TEXT_LEFT, "VRAM: %d / %d MB used",
+              (totalKB - availableKB) / 1024, totalKB / 1024);
+  } else if (overlay->memoryQuery == 2) {
+    GLint freeKB[4] = {0};
+    glGetIntegerv(OVERLAY_TEXTURE_FREE_MEMORY_ATI, freeKB);
+    nk_labelf(ctx, NK_TEXT_LEFT, "VRAM: %d MB free", freeKB[0] / 1024);
+  } else {
+    nk_label(ctx, "VRAM: n/a (no NVX/ATI meminfo)", NK_TEXT_LEFT);
+  }
+
+  // Profiler scopes (rolling averages)
+  const ProfilerScope *scopes;
+  int scopeCount = Profiler_GetScopes(&scopes);
+  nk_layout_row_dynamic(ctx, 14, 3);
+  nk_label(ctx, "Scope", NK_TEXT_LEFT);
+  nk_label(ctx, "GPU ms", NK_TEXT_RIGHT);
+  nk_label(ctx, "CPU ms", NK_TEXT_RIGHT);
+  for (int i = 0; i < scopeCount; i++) {
+    char label[64];
+    snprintf(label, sizeof(label), "%*s%s", scopes[i].depth * 2, "",
+             scopes[i].name);
+    nk_label(ctx, label, NK_TEXT_LEFT);
+    nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f", scopes[i].gpuMs);
+    nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f", scopes[i].cpuMs);
+  }
+
+done:
+  nk_end(ctx);
+}
+
+static void draw(int width, int height) {
+  static const struct nk_draw_vertex_layout_element layout[] = {
+      {NK_VERTEX_POSITION, NK_FORMAT_FLOAT,
+       NK_OFFSETOF(OverlayVertex, position)},
+      {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, NK_OFFSETOF(OverlayVertex, uv)},
+      {NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, NK_OFFSETOF(OverlayVertex, color)},
+      {NK_VERTEX_LAYOUT_END}};
+
+  struct nk_convert_config config;
+  memset(&config, 0, sizeof(config));
+  config.vertex_layout = layout;
+  config.vertex_size = sizeof(OverlayVertex);
+  config.vertex_alignment = NK_ALIGNOF(OverlayVertex);
+  config.null = overlay->nullTexture;
+  config.circle_segment_count = 22;
+  config.curve_segment_count = 22;
+  config.arc_segment_count = 22;
+  config.global_alpha = 1.0f;
+  config.shape_AA = NK_ANTI_ALIASING_ON;
+  config.line_AA = NK_ANTI_ALIASING_ON;
+
+  struct nk_buffer vbuf, ebuf;
+  nk_buffer_init_fixed(&vbuf, overlay->vertices, OVERLAY_MAX_VERTEX_BYTES);
+  nk_buffer_init_fixed(&ebuf, overlay->indices, OVERLAY_MAX_INDEX_BYTES);
+  nk_convert(&overlay->ctx, &overlay->commands, &vbuf, &ebuf, &config);
+
+  GLState_Enable(GL_BLEND);
+  GLState_BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GLState_Disable(GL_CULL_FACE);
+  GLState_Disable(GL_DEPTH_TEST);
+  GLState_Enable(GL_SCISSOR_TEST);
+  GLState_Viewport(0, 0, width, height);
+
+  // Pixel coordinates (origin top left) to NDC
+  float ortho[16] = {2.0f / width, 0, 0, 0, 0, -2.0f / height, 0, 0,
+                     0,            0, -1, 0, -1, 1,            0, 1};
+  Shader_Use(overlay->program);
+  Shader_UniformMat4(overlay->orthoProjection, ortho);
+  Shader_UniformInt(overlay->atlasSampler, 0);
+
+  GLState_BindVertexArray(overlay->VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, overlay->VBO);
+  glBufferData(GL_ARRAY_BUFFER, nk_buffer_total(&vbuf), overlay->vertices,
+               GL_STREAM_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, overlay->EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, nk_buffer_total(&ebuf),
+               overlay->indices, GL_STREAM_DRAW);
+
+  const struct nk_draw_command *cmd;
+  const nk_draw_index *offset = NULL;
+  nk_draw_foreach(cmd, &overlay->ctx, &overlay->commands) {
+    if (!cmd->elem_count)
+      continue;
+    GLState_BindTexture(0, (GLuint)cmd->texture.id);
+    glScissor((GLint)cmd->clip_rect.x,
+              (GLint)(height - (cmd->clip_rect.y + cmd->clip_rect.h)),
+              (GLint)cmd->clip_rect.w, (GLint)cmd->clip_rect.h);
+    glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT,
+                   offset);
+    offset += cmd->elem_count;
+  }
+  nk_clear(&overlay->ctx);
+  nk_buffer_clear(&overlay->commands);
+
+  GLState_Disable(GL_SCISSOR_TEST);
+  GLState_Enable(GL_DEPTH_TEST);
+  GLState_Enable(GL_CULL_FACE);
+  GLState_Disable(GL_BLEND);
+}
+
+void Overlay_Render(int width, int height, float frameMs) {
+  if (!visible)
+    return;
+  if (!overlay)
+    overlayInit();
+
+  pushHistory(frameMs);
+  buildUI(&overlay->ctx, height, frameMs);
+  draw(width, height);
+  // Exclude the overlay's own uniform uploads and state changes from the
+  // next frame's count
+  lastShaderStats = Shader_GetStats();
+  lastStateStats = GLState_GetStats();
+}
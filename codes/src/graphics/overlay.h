@@ -0,0 +1,20 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include "../core/window.h"
+
+#define OVERLAY_TOGGLE_KEY GLFW_KEY_F1
+#define OVERLAY_HISTORY 120 // frames shown in the frame time graph
+
+// Performance overlay drawn with the bundled Nuklear: frame time graph,
+// profiler scopes, draw/triangle counts, uniform uploads and VRAM usage.
+// Nothing (not even the UI context) is created until it is first shown, and
+// while hidden Overlay_Render returns immediately.
+
+// Checks the toggle key; call once per frame
+void Overlay_HandleInput(GLFWwindow *window);
+int Overlay_IsVisible(void);
+// Draws on top of the currently bound framebuffer
+void Overlay_Render(int width, int height, float frameMs);
+
+#endif
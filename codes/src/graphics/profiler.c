@@ -0,0 +1,170 @@
+#include "profiler.h"
+#include "../core/window.h"
+#include "../utils/log.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PROFILER_FRAMES 2       // query sets in flight
+#define PROFILER_SMOOTHING 0.1  // weight of the newest sample
+
+// Timestamp queries issued during one frame. Timestamps rather than
+// GL_TIME_ELAPSED so scopes can nest (and coexist with the bench's frame
+// query); a scope's GPU time is end - begin.
+typedef struct {
+  GLuint queries[PROFILER_MAX_EVENTS * 2];
+  int eventScope[PROFILER_MAX_EVENTS];
+  int eventCount;
+} ProfilerFrame;
+
+typedef struct {
+  int scope;
+  int event; // -1 when the frame ran out of queries
+  double cpuStart;
+} ProfilerOpen;
+
+static ProfilerScope scopes[PROFILER_MAX_SCOPES];
+static int scopeCount = 0;
+static ProfilerFrame frames[PROFILER_FRAMES];
+static int frameIndex = -1;
+static ProfilerOpen stack[PROFILER_MAX_DEPTH];
+static int stackDepth = 0;
+static int dropped = 0; // frames whose results were not ready in time
+// CPU time of each scope so far this frame, -1 when it has not run
+static double cpuFrameMs[PROFILER_MAX_SCOPES];
+
+void Profiler_Init(void) {
+  for (int i = 0; i < PROFILER_FRAMES; i++) {
+    glGenQueries(PROFILER_MAX_EVENTS * 2, frames[i].queries);
+    frames[i].eventCount = 0;
+  }
+  for (int i = 0; i < PROFILER_MAX_SCOPES; i++)
+    cpuFrameMs[i] = -1.0;
+}
+
+static void addSample(double *avg, int samples, double value) {
+  *avg = samples == 0 ? value : *avg + (value - *avg) * PROFILER_SMOOTHING;
+}
+
+// Reads back a finished frame if the GPU is done with it. A scope that ran
+// several times in the frame (e.g. a render queue stage split by sorting)
+// gets one sample, their sum.
+static void collect(ProfilerFrame *frame) {
+  if (frame->eventCount == 0)
+    return;
+  GLuint available = 0;
+  glGetQueryObjectuiv(frame->queries[frame->eventCount * 2 - 1],
+                      GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    dropped++;
+    return;
+  }
+  double gpuFrameMs[PROFILER_MAX_SCOPES];
+  for (int i = 0; i < scopeCount; i++)
+    gpuFrameMs[i] = -1.0;
+  for (int e = 0; e < frame->eventCount; e++) {
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame->queries[e * 2], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame->queries[e * 2 + 1], GL_QUERY_RESULT, &end);
+    double *ms = &gpuFrameMs[frame->eventScope[e]];
+    *ms = (*ms < 0.0 ? 0.0 : *ms) + (end - begin) / 1.0e6;
+  }
+  for (int i = 0; i < scopeCount; i++)
+    if (gpuFrameMs[i] >= 0.0)
+      addSample(&scopes[i].gpuMs, scopes[i].gpuSamples++, gpuFrameMs[i]);
+}
+
+// Turns last frame's CPU times into samples
+static void collectCpu(void) {
+  for (int i = 0; i < scopeCount; i++) {
+    if (cpuFrameMs[i] < 0.0)
+      continue;
+    addSample(&scopes[i].cpuMs, scopes[i].cpuSamples++, cpuFrameMs[i]);
+    cpuFrameMs[i] = -1.0;
+  }
+}
+
+void Profiler_BeginFrame(void) {
+  frameIndex++;
+  ProfilerFrame *frame = &frames[frameIndex % PROFILER_FRAMES];
+  collect(frame);
+  collectCpu();
+  frame->eventCount = 0;
+  stackDepth = 0;
+}
+
+static int findScope(const char *name, int parent) {
+  for (int i = 0; i < scopeCount; i++) {
+    if (scopes[i].parent == parent &&
+        (scopes[i].name == name || strcmp(scopes[i].name, name) == 0))
+      return i;
+  }
+  if (scopeCount == PROFILER_MAX_SCOPES)
+    return -1;
+  ProfilerScope *s = &scopes[scopeCount];
+  memset(s, 0, sizeof(*s));
+  s->name = name;
+  s->parent = parent;
+  s->depth = parent < 0 ? 0 : scopes[parent].depth + 1;
+  return scopeCount++;
+}
+
+void Profiler_Begin(const char *name) {
+  if (frameIndex < 0 || stackDepth >= PROFILER_MAX_DEPTH) {
+    stackDepth++; // keep Begin/End balanced
+    return;
+  }
+  int parent = stackDepth > 0 ? stack[stackDepth - 1].scope : -1;
+  ProfilerOpen *open = &stack[stackDepth++];
+  open->scope = findScope(name, parent);
+  open->event = -1;
+  open->cpuStart = glfwGetTime();
+
+  ProfilerFrame *frame = &frames[frameIndex % PROFILER_FRAMES];
+  if (open->scope >= 0 && frame->eventCount < PROFILER_MAX_EVENTS) {
+    open->event = frame->eventCount++;
+    frame->eventScope[open->event] = open->scope;
+    glQueryCounter(frame->queries[open->event * 2], GL_TIMESTAMP);
+  }
+}
+
+void Profiler_End(void) {
+  if (stackDepth == 0)
+    return;
+  stackDepth--;
+  if (frameIndex < 0 || stackDepth >= PROFILER_MAX_DEPTH)
+    return;
+  ProfilerOpen *open = &stack[stackDepth];
+  if (open->scope < 0)
+    return;
+  if (open->event >= 0) {
+    ProfilerFrame *frame = &frames[frameIndex % PROFILER_FRAMES];
+    glQueryCounter(frame->queries[open->event * 2 + 1], GL_TIMESTAMP);
+  }
+  double *ms = &cpuFrameMs[open->scope];
+  *ms = (*ms < 0.0 ? 0.0 : *ms) + (glfwGetTime() - open->cpuStart) * 1000.0;
+}
+
+static void reportChildren(int parent) {
+  for (int i = 0; i < scopeCount; i++) {
+    if (scopes[i].parent != parent)
+      continue;
+    char label[64];
+    snprintf(label, sizeof(label), "%*s%s", scopes[i].depth * 2, "",
+             scopes[i].name);
+    Log_Info("Profiler: %-24s %9.3f %9.3f", label, scopes[i].gpuMs,
+             scopes[i].cpuMs);
+    reportChildren(i);
+  }
+}
+
+void Profiler_Report(void) {
+  Log_Info("Profiler: %-24s %9s %9s", "scope", "gpu ms", "cpu ms");
+  reportChildren(-1);
+  if (dropped > 0)
+    Log_Warn("Profiler: %d frames dropped (GPU results not ready)", dropped);
+}
+
+int Profiler_GetScopes(const ProfilerScope **out) {
+  *out = scopes;
+  return scopeCount;
+}
@@ -0,0 +1,34 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Named, nestable GPU/CPU timing scopes. GPU times come from timestamp
+// queries that are double-buffered: a frame's results are collected two
+// frames later and dropped rather than waited on if not yet available.
+// Times are kept as rolling averages per scope.
+
+#define PROFILER_MAX_SCOPES 64
+#define PROFILER_MAX_EVENTS 128 // scope instances per frame
+#define PROFILER_MAX_DEPTH 8
+
+typedef struct {
+  const char *name;
+  int parent; // -1 for top level scopes
+  int depth;
+  double gpuMs; // rolling averages
+  double cpuMs;
+  int gpuSamples;
+  int cpuSamples;
+} ProfilerScope;
+
+void Profiler_Init(void);
+void Profiler_BeginFrame(void);
+// name must stay valid (string literal); same name under another parent is
+// a separate scope
+void Profiler_Begin(const char *name);
+void Profiler_End(void);
+// Prints every scope as a tree with its averaged GPU and CPU time
+void Profiler_Report(void);
+
+int Profiler_GetScopes(const ProfilerScope **scopes);
+
+#endif
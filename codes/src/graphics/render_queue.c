@@ -0,0 +1,254 @@
+#include "render_queue.h"
+#include "gl_state.h"
+#include "mesh_cluster.h"
+#include "profiler.h"
+#include "render_stats.h"
+#include "../utils/log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_SEQ_BITS 12
+#define KEY_DEPTH_BITS 24
+#define KEY_VAO_BITS 12
+#define KEY_MATERIAL_BITS 10
+
+#define KEY_DEPTH_SHIFT KEY_SEQ_BITS
+#define KEY_VAO_SHIFT (KEY_DEPTH_SHIFT + KEY_DEPTH_BITS)
+#define KEY_MATERIAL_SHIFT (KEY_VAO_SHIFT + KEY_VAO_BITS)
+#define KEY_PROGRAM_SHIFT (KEY_MATERIAL_SHIFT + KEY_MATERIAL_BITS)
+
+void RenderQueue_Init(RenderQueue *queue) {
+  memset(queue, 0, sizeof(RenderQueue));
+}
+
+void RenderQueue_Begin(RenderQueue *queue, const Frustum *frustum,
+                       const Occlusion *occlusion, int reflectionPass,
+                       const LodView *view) {
+  queue->count = 0;
+  queue->rangeCount = 0;
+  queue->frustum = frustum;
+  queue->occlusion = occlusion;
+  queue->reflectionPass = reflectionPass;
+  queue->view = *view;
+}
+
+// -1 when the program table is full; Flush needs every program's uniforms
+static int programRank(RenderQueue *queue, GLuint program) {
+  for (int i = 0; i < queue->programCount; i++)
+    if (queue->programs[i].program == program)
+      return i;
+  if (queue->programCount == RENDER_QUEUE_MAX_PROGRAMS)
+    return -1;
+
+  // Material uniforms are resolved once per program
+  RenderQueueProgram *p = &queue->programs[queue->programCount];
+  p->program = program;
+  p->model = Shader_GetUniform(program, "model");
+  p->normalMatrix = Shader_GetUniform(program, "normalMatrix");
+  p->color = Shader_GetUniform(program, "objectColor");
+  p->shininess = Shader_GetUniform(program, "shininess");
+  p->specularIntensity = Shader_GetUniform(program, "specularIntensity");
+  return queue->programCount++;
+}
+
+static int materialRank(RenderQueue *queue, const Material *material) {
+  for (int i = 0; i < queue->materialCount; i++)
+    if (queue->materials[i] == material)
+      return i;
+  if (queue->materialCount == RENDER_QUEUE_MAX_MATERIALS)
+    return RENDER_QUEUE_MAX_MATERIALS - 1;
+  queue->materials[queue->materialCount] = material;
+  return queue->materialCount++;
+}
+
+// Distance from the eye to the nearest point of the sphere
+static uint64_t quantizeDepth(const RenderQueue *queue, const float center[3],
+                              float radius) {
+  float dx = center[0] - queue->view.position[0];
+  float dy = center[1] - queue->view.position[1];
+  float dz = center[2] - queue->view.position[2];
+  float d = sqrtf(dx * dx + dy * dy + dz * dz) - radius;
+  if (d < 0.0f)
+    d = 0.0f;
+  if (d > RENDER_QUEUE_DEPTH_RANGE)
+    d = RENDER_QUEUE_DEPTH_RANGE;
+  uint64_t maxDepth = (1ull << KEY_DEPTH_BITS) - 1;
+  return (uint64_t)(d / RENDER_QUEUE_DEPTH_RANGE * (float)maxDepth);
+}
+
+static RenderItem *push(RenderQueue *queue, const Material *material,
+                        GLuint vao, const float center[3], float radius) {
+  if (queue->count == RENDER_QUEUE_MAX_ITEMS) {
+    Log_Warn("RenderQueue: full, dropping draw");
+    return NULL;
+  }
+  int programIndex = programRank(queue, material->program);
+  if (programIndex < 0) {
+    Log_Warn("RenderQueue: too many programs, dropping draw");
+    return NULL;
+  }
+  RenderItem *item = &queue->items[queue->count];
+  uint64_t program = (uint64_t)programIndex;
+  uint64_t rank = (uint64_t)materialRank(queue, material);
+  item->key = program << KEY_PROGRAM_SHIFT | rank << KEY_MATERIAL_SHIFT |
+              (uint64_t)(vao & ((1u << KEY_VAO_BITS) - 1)) << KEY_VAO_SHIFT |
+              quantizeDepth(queue, center, radius) << KEY_DEPTH_SHIFT |
+              (uint64_t)queue->count;
+  item->material = material;
+  item->mesh = NULL;
+  item->batch = NULL;
+  item->impostor = NULL;
+  item->rangeFirst = 0;
+  item->rangeCount = 0;
+  queue->count++;
+  return item;
+}
+
+static void reserveRanges(RenderQueue *queue, int extra) {
+  int needed = queue->rangeCount + extra;
+  if (needed <= queue->rangeCapacity)
+    return;
+  int capacity = queue->rangeCapacity ? queue->rangeCapacity : 64;
+  while (capacity < needed)
+    capacity *= 2;
+  queue->rangeCounts =
+      (GLsizei *)realloc(queue->rangeCounts, capacity * sizeof(GLsizei));
+  queue->rangeOffsets = (const void **)realloc(
+      queue->rangeOffsets, capacity * sizeof(const void *));
+  queue->rangeCapacity = capacity;
+}
+
+// Culls the clusters of a level 0 mesh into the free ranges after the
+// queued ones, which its item claims once pushed; 0 when none is left
+static int cullClusters(RenderQueue *queue, Mesh *mesh, mat4 model) {
+  reserveRanges(queue, mesh->clusterCount);
+  return MeshCluster_Cull(mesh, model, queue->frustum, queue->occlusion,
+                          queue->view.position, !queue->reflectionPass,
+                          queue->rangeCounts + queue->rangeCount,
+                          queue->rangeOffsets + queue->rangeCount);
+}
+
+void RenderQueue_SubmitMesh(RenderQueue *queue, const Material *material,
+                            Mesh *mesh, mat4 model) {
+  if (!Culling_IsVisible(queue->frustum, queue->occlusion, mesh, model))
+    return;
+  float center[3], radius;
+  Culling_TransformSphere(mesh, model.m, center, &radius);
+  int lod = Mesh_SelectLod(mesh, &queue->view, center, radius);
+  int rangeCount = 0;
+  if (lod == 0 && mesh->clusterCount > 0) {
+    rangeCount = cullClusters(queue, mesh, model);
+    if (rangeCount == 0) {
+      RenderStats_AddCulling(-1, 1); // every cluster was culled
+      return;
+    }
+  }
+  RenderItem *item = push(queue, material, mesh->VAO, center, radius);
+  if (item) {
+    item->mesh = mesh;
+    item->lod = lod;
+    item->rangeFirst = queue->rangeCount;
+    item->rangeCount = rangeCount;
+    queue->rangeCount += rangeCount;
+    mat4 position = Mesh_PositionMatrix(mesh, model);
+    memcpy(item->model, position.m, sizeof(item->model));
+    mat4_normal_matrix(model, item->normalMatrix);
+  }
+}
+
+void RenderQueue_SubmitBatch(RenderQueue *queue, const Material *material,
+                             StaticBatch *batch) {
+  int candidates =
+      queue->reflectionPass ? batch->reflectionCount : batch->count;
+  if (candidates == 0)
+    return;
+  RenderItem *item = push(queue, material, batch->mesh->VAO, batch->bounds,
+                          batch->bounds[3]);
+  if (item)
+    item->batch = batch;
+}
+
+void RenderQueue_SubmitImpostors(RenderQueue *queue, const Material *material,
+                                 Impostor *impostor) {
+  StaticBatch *batch = impostor->batch;
+  if (!batch)
+    return; // nothing was captured
+  int candidates =
+      queue->reflectionPass ? batch->reflectionCount : batch->count;
+  if (candidates == 0)
+    return;
+  RenderItem *item =
+      push(queue, material, impostor->VAO, batch->bounds, batch->bounds[3]);
+  if (item)
+    item->impostor = impostor;
+}
+
+static int compareItems(const void *a, const void *b) {
+  uint64_t ka = ((const RenderItem *)a)->key;
+  uint64_t kb = ((const RenderItem *)b)->key;
+  return (ka > kb) - (ka < kb);
+}
+
+static const RenderQueueProgram *findProgram(const RenderQueue *queue,
+                                             GLuint program) {
+  for (int i = 0; i < queue->programCount; i++)
+    if (queue->programs[i].program == program)
+      return &queue->programs[i];
+  return NULL;
+}
+
+void RenderQueue_Flush(RenderQueue *queue) {
+  qsort(queue->items, queue->count, sizeof(RenderItem), compareItems);
+
+  const RenderQueueProgram *program = NULL;
+  const Material *material = NULL;
+  const char *stage = NULL;
+  for (int i = 0; i < queue->count; i++) {
+    RenderItem *item = &queue->items[i];
+    const Material *m = item->material;
+    if (m->stage != stage) {
+      if (stage)
+        Profiler_End();
+      stage = m->stage;
+      if (stage)
+        Profiler_Begin(stage);
+    }
+    if (!program || program->program != m->program) {
+      program = findProgram(queue, m->program);
+      Shader_Use(m->program);
+      material = NULL;
+    }
+    if (m != material) {
+      if (m->normalMap)
+        GLState_BindTexture(0, m->normalMap);
+      if (m->diffuseMap)
+        GLState_BindTexture(1, m->diffuseMap);
+      Shader_UniformVec3(program->color, m->color[0], m->color[1],
+                         m->color[2]);
+      Shader_UniformFloat(program->shininess, m->shininess);
+      Shader_UniformFloat(program->specularIntensity, m->specularIntensity);
+      material = m;
+    }
+
+    if (item->impostor) {
+      Impostor_Draw(item->impostor, m->program, queue->frustum,
+                    queue->occlusion, queue->reflectionPass, &queue->view);
+    } else if (item->batch) {
+      StaticBatch_Draw(item->batch, queue->frustum, queue->occlusion,
+                       queue->reflectionPass, &queue->view);
+    } else {
+      Shader_UniformMat4(program->model, item->model);
+      Shader_UniformMat3(program->normalMatrix, item->normalMatrix);
+      if (item->rangeCount > 0)
+        Mesh_DrawRanges(item->mesh, queue->rangeCounts + item->rangeFirst,
+                        queue->rangeOffsets + item->rangeFirst,
+                        item->rangeCount);
+      else
+        Mesh_DrawLod(item->mesh, item->lod);
+    }
+  }
+  if (stage)
+    Profiler_End();
+  queue->count = 0;
+}
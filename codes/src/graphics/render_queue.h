@@ -0,0 +1,99 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "culling.h"
+#include "impostor.h"
+#include "mesh.h"
+#include "shader.h"
+#include "static_batch.h"
+#include <stdint.h>
+
+#define RENDER_QUEUE_MAX_ITEMS 256
+#define RENDER_QUEUE_MAX_PROGRAMS 16
+#define RENDER_QUEUE_MAX_MATERIALS 64
+#define RENDER_QUEUE_DEPTH_RANGE 2000.0f // matches the far plane
+
+// Program, textures and floor.frag material uniforms shared by draws.
+// Texture handles of 0 are left unbound (the variant does not sample them).
+typedef struct {
+  GLuint program;
+  GLuint normalMap;  // texture unit 0
+  GLuint diffuseMap; // texture unit 1
+  float color[3];
+  float shininess;
+  float specularIntensity;
+  const char *stage; // profiler scope its draws are timed under (a literal)
+} Material;
+
+// Sort key, most significant first:
+//   program rank (6) | material rank (10) | VAO (12) | depth (24) | seq (12)
+// so the sorted list changes program, then textures, then vertex arrays as
+// rarely as possible, and draws sharing all three go front to back for
+// early depth rejection. Ranks follow first submission, so they are stable
+// from frame to frame.
+typedef struct {
+  uint64_t key;
+  const Material *material;
+  Mesh *mesh;         // single placement drawn with the model uniform
+  StaticBatch *batch; // or an instanced batch, culled when executed
+  Impostor *impostor; // or the far instances of a batch
+  int lod;            // detail level of the single mesh
+  // Visible clusters of a clustered mesh at level 0, as a span of the
+  // queue's ranges; rangeCount 0 draws the whole level
+  int rangeFirst;
+  int rangeCount;
+  float model[16];
+  float normalMatrix[9];
+} RenderItem;
+
+typedef struct {
+  GLuint program;
+  ShaderUniform model;
+  ShaderUniform normalMatrix;
+  ShaderUniform color;
+  ShaderUniform shininess;
+  ShaderUniform specularIntensity;
+} RenderQueueProgram;
+
+typedef struct {
+  RenderItem items[RENDER_QUEUE_MAX_ITEMS];
+  int count;
+  RenderQueueProgram programs[RENDER_QUEUE_MAX_PROGRAMS];
+  int programCount;
+  const Material *materials[RENDER_QUEUE_MAX_MATERIALS];
+  int materialCount;
+  // Set by RenderQueue_Begin for the current pass
+  const Frustum *frustum;
+  const Occlusion *occlusion; // may be NULL
+  int reflectionPass;
+  LodView view;
+  // Index ranges of the visible clusters of every queued mesh
+  GLsizei *rangeCounts;
+  const void **rangeOffsets;
+  int rangeCount;
+  int rangeCapacity;
+} RenderQueue;
+
+void RenderQueue_Init(RenderQueue *queue);
+// Starts collecting opaque draws for one pass; frustum and occlusion must
+// outlive Flush. view orders the draws by depth and picks their detail
+// levels.
+void RenderQueue_Begin(RenderQueue *queue, const Frustum *frustum,
+                       const Occlusion *occlusion, int reflectionPass,
+                       const LodView *view);
+// Culls the placement and picks its detail level now; invisible or occluded
+// meshes are not queued. Clustered meshes drawn at level 0 are also culled
+// per cluster, by normal cone too except in the two sided reflection pass.
+void RenderQueue_SubmitMesh(RenderQueue *queue, const Material *material,
+                            Mesh *mesh, mat4 model);
+void RenderQueue_SubmitBatch(RenderQueue *queue, const Material *material,
+                             StaticBatch *batch);
+// Queues the impostor quads of its batch's far instances, if Impostor_Init
+// captured anything; material takes the impostor program and atlases
+void RenderQueue_SubmitImpostors(RenderQueue *queue, const Material *material,
+                                 Impostor *impostor);
+// Sorts and draws everything submitted since Begin, timing each run of
+// draws sharing a material stage as a profiler scope
+void RenderQueue_Flush(RenderQueue *queue);
+
+#endif
@@ -0,0 +1,20 @@
+#include "render_stats.h"
+#include <string.h>
+
+static RenderStats stats;
+
+void RenderStats_Reset(void) { memset(&stats, 0, sizeof(stats)); }
+
+void RenderStats_AddDraw(int indexCount, int instanceCount) {
+  stats.drawCalls++;
+  stats.triangles += indexCount / 3 * instanceCount;
+}
+
+void RenderStats_AddCulling(int visible, int culled) {
+  stats.visible += visible;
+  stats.culled += culled;
+}
+
+void RenderStats_AddOcclusion(int occluded) { stats.occluded += occluded; }
+
+RenderStats RenderStats_Get(void) { return stats; }
@@ -0,0 +1,19 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// Per-frame counters, reset by the main loop at the start of each frame
+typedef struct {
+  int drawCalls;
+  int triangles;
+  int visible; // objects and instances submitted after culling
+  int culled;  // objects and instances rejected by culling
+  int occluded; // of the culled, those rejected by the Hi-Z test
+} RenderStats;
+
+void RenderStats_Reset(void);
+void RenderStats_AddDraw(int indexCount, int instanceCount);
+void RenderStats_AddCulling(int visible, int culled);
+void RenderStats_AddOcclusion(int occluded);
+RenderStats RenderStats_Get(void);
+
+#endif
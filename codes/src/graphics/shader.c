@@ -1,7 +1,72 @@
 #include "shader.h"
+#include "gl_state.h"
+#include "shader_cache.h"
 #include "../utils/file_utils.h"
+#include "../utils/log.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define SHADER_UNIFORM_NAME_MAX 64
+
+// One entry per active uniform, filled by introspection after linking.
+// value caches the last upload so redundant sets can be dropped.
+struct ShaderUniformSlot {
+  char name[SHADER_UNIFORM_NAME_MAX];
+  unsigned int hash;
+  GLint location;
+  int valid;
+  float value[16];
+};
+
+typedef struct {
+  GLuint program;
+  int uniformCount;
+  struct ShaderUniformSlot *uniforms;
+} ProgramTable;
+
+static ProgramTable *programTables = NULL;
+static int programTableCount = 0;
+static ShaderStats stats;
+
+static unsigned int hashName(const char *name) {
+  unsigned int h = 2166136261u;
+  while (*name)
+    h = (h ^ (unsigned char)*name++) * 16777619u;
+  return h;
+}
+
+static void buildUniformTable(GLuint prog) {
+  GLint count = 0;
+  glGetProgramiv(prog, GL_ACTIVE_UNIFORMS, &count);
+
+  ProgramTable table;
+  table.program = prog;
+  table.uniformCount = 0;
+  table.uniforms = (struct ShaderUniformSlot *)calloc(
+      count > 0 ? count : 1, sizeof(struct ShaderUniformSlot));
+
+  for (GLint i = 0; i < count; i++) {
+    struct ShaderUniformSlot *slot = &table.uniforms[table.uniformCount];
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(prog, (GLuint)i, SHADER_UNIFORM_NAME_MAX, NULL, &size,
+                       &type, slot->name);
+    // Array uniforms are reported as "name[0]"; register them as "name"
+    char *bracket = strchr(slot->name, '[');
+    if (bracket)
+      *bracket = '\0';
+    slot->location = glGetUniformLocation(prog, slot->name);
+    if (slot->location < 0) // uniform block members have no location
+      continue;
+    slot->hash = hashName(slot->name);
+    table.uniformCount++;
+  }
+
+  programTables = (ProgramTable *)realloc(
+      programTables, (programTableCount + 1) * sizeof(ProgramTable));
+  programTables[programTableCount++] = table;
+}
 
 void checkCompileErrors(GLuint shader, const char *type) {
   GLint success;
@@ -23,29 +88,76 @@ void checkCompileErrors(GLuint shader, const char *type) {
   }
 }
 
-GLuint Shader_Create(const char *vertPath, const char *fragPath) {
+static const char *featureDefines[SHADER_FEATURE_COUNT] = {
+    "DIFFUSE_MAP", "NORMAL_MAP", "INSTANCED", "IMPOSTOR",
+    "IMPOSTOR_CAPTURE"};
+
+static void buildDefines(unsigned int features, char *out, size_t outSize) {
+  size_t len = 0;
+  out[0] = '\0';
+  for (int i = 0; i < SHADER_FEATURE_COUNT; i++) {
+    if (features & (1u << i))
+      len += snprintf(out + len, outSize - len, "#define %s\n",
+                      featureDefines[i]);
+  }
+  // Keep compiler messages on the line numbers of the file
+  if (len > 0)
+    snprintf(out + len, outSize - len, "#line 2\n");
+}
+
+// Compiles src with defines inserted right after its #version line
+static GLuint compileStage(GLenum type, const char *src, const char *defines,
+                           const char *typeName) {
+  const char *body = strchr(src, '\n');
+  body = body ? body + 1 : src + strlen(src);
+  const GLchar *parts[3] = {src, defines, body};
+  GLint lengths[3] = {(GLint)(body - src), -1, -1};
+
+  GLuint stage = glCreateShader(type);
+  glShaderSource(stage, 3, parts, lengths);
+  glCompileShader(stage);
+  checkCompileErrors(stage, typeName);
+  return stage;
+}
+
+GLuint Shader_CreateVariant(const char *vertPath, const char *fragPath,
+                            unsigned int features) {
   char *vSrc = readFile(vertPath);
   char *fSrc = readFile(fragPath);
   if (!vSrc || !fSrc) {
     printf("Failed to read shaders: %s, %s\n", vertPath, fragPath);
     exit(1);
   }
+  char defines[256];
+  buildDefines(features, defines, sizeof(defines));
 
-  GLuint vShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vShader, 1, (const GLchar **)&vSrc, NULL);
-  glCompileShader(vShader);
-  checkCompileErrors(vShader, "VERTEX");
+  // A cached binary for the same sources and driver skips compilation
+  double start = glfwGetTime();
+  uint64_t key = ShaderCache_Key(defines, vSrc, fSrc);
+  GLuint prog = ShaderCache_Load(vertPath, fragPath, features, key);
+  if (prog) {
+    Log_Debug("Shader: %s + %s (0x%x) loaded from program cache in %.1f ms",
+              vertPath, fragPath, features, (glfwGetTime() - start) * 1000.0);
+    buildUniformTable(prog);
+    free(vSrc);
+    free(fSrc);
+    return prog;
+  }
 
-  GLuint fShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fShader, 1, (const GLchar **)&fSrc, NULL);
-  glCompileShader(fShader);
-  checkCompileErrors(fShader, "FRAGMENT");
+  GLuint vShader = compileStage(GL_VERTEX_SHADER, vSrc, defines, "VERTEX");
+  GLuint fShader = compileStage(GL_FRAGMENT_SHADER, fSrc, defines, "FRAGMENT");
 
-  GLuint prog = glCreateProgram();
+  prog = glCreateProgram();
   glAttachShader(prog, vShader);
   glAttachShader(prog, fShader);
+  if (ShaderCache_IsSupported())
+    glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glLinkProgram(prog);
   checkCompileErrors(prog, "PROGRAM");
+  buildUniformTable(prog);
+  Log_Debug("Shader: %s + %s (0x%x) compiled in %.1f ms", vertPath, fragPath,
+            features, (glfwGetTime() - start) * 1000.0);
+  ShaderCache_Store(vertPath, fragPath, features, key, prog);
 
   free(vSrc);
   free(fSrc);
@@ -54,24 +166,132 @@ GLuint Shader_Create(const char *vertPath, const char *fragPath) {
   return prog;
 }
 
-void Shader_Use(GLuint program) { glUseProgram(program); }
+GLuint Shader_Create(const char *vertPath, const char *fragPath) {
+  return Shader_CreateVariant(vertPath, fragPath, 0);
+}
+
+void ShaderVariants_Init(ShaderVariants *variants, const char *vertPath,
+                         const char *fragPath, ShaderSetupFn setup) {
+  memset(variants, 0, sizeof(*variants));
+  variants->vertPath = vertPath;
+  variants->fragPath = fragPath;
+  variants->setup = setup;
+}
+
+GLuint ShaderVariants_Get(ShaderVariants *variants, unsigned int features) {
+  GLuint *prog = &variants->programs[features & (SHADER_VARIANT_COUNT - 1)];
+  if (!*prog) {
+    *prog = Shader_CreateVariant(variants->vertPath, variants->fragPath,
+                                 features);
+    if (variants->setup)
+      variants->setup(*prog);
+  }
+  return *prog;
+}
+
+void Shader_Use(GLuint program) { GLState_UseProgram(program); }
+
+ShaderUniform Shader_GetUniform(GLuint program, const char *name) {
+  static int lastTable = 0; // consecutive lookups usually hit one program
+  ProgramTable *table = NULL;
+  if (lastTable < programTableCount &&
+      programTables[lastTable].program == program) {
+    table = &programTables[lastTable];
+  } else {
+    for (int i = 0; i < programTableCount; i++) {
+      if (programTables[i].program == program) {
+        table = &programTables[i];
+        lastTable = i;
+        break;
+      }
+    }
+  }
+  if (!table)
+    return NULL;
+
+  unsigned int hash = hashName(name);
+  for (int i = 0; i < table->uniformCount; i++) {
+    struct ShaderUniformSlot *slot = &table->uniforms[i];
+    if (slot->hash == hash && strcmp(slot->name, name) == 0)
+      return slot;
+  }
+  return NULL;
+}
+
+// Returns 1 if the value differs from the last upload (and records it)
+static int uniformChanged(ShaderUniform u, const void *value, size_t size) {
+  if (u->valid && memcmp(u->value, value, size) == 0) {
+    stats.filtered++;
+    return 0;
+  }
+  memcpy(u->value, value, size);
+  u->valid = 1;
+  stats.uploads++;
+  return 1;
+}
+
+void Shader_UniformInt(ShaderUniform u, int value) {
+  if (u && uniformChanged(u, &value, sizeof(value)))
+    glUniform1i(u->location, value);
+}
+
+void Shader_UniformFloat(ShaderUniform u, float value) {
+  if (u && uniformChanged(u, &value, sizeof(value)))
+    glUniform1f(u->location, value);
+}
+
+void Shader_UniformVec2(ShaderUniform u, float x, float y) {
+  float v[2] = {x, y};
+  if (u && uniformChanged(u, v, sizeof(v)))
+    glUniform2f(u->location, x, y);
+}
+
+void Shader_UniformVec3(ShaderUniform u, float x, float y, float z) {
+  float v[3] = {x, y, z};
+  if (u && uniformChanged(u, v, sizeof(v)))
+    glUniform3f(u->location, x, y, z);
+}
+
+void Shader_UniformVec4(ShaderUniform u, float x, float y, float z, float w) {
+  float v[4] = {x, y, z, w};
+  if (u && uniformChanged(u, v, sizeof(v)))
+    glUniform4f(u->location, x, y, z, w);
+}
+
+void Shader_UniformMat3(ShaderUniform u, const float *value) {
+  if (u && uniformChanged(u, value, 9 * sizeof(float)))
+    glUniformMatrix3fv(u->location, 1, GL_FALSE, value);
+}
+
+void Shader_UniformMat4(ShaderUniform u, const float *value) {
+  if (u && uniformChanged(u, value, 16 * sizeof(float)))
+    glUniformMatrix4fv(u->location, 1, GL_FALSE, value);
+}
+
+ShaderStats Shader_GetStats(void) { return stats; }
+
+void Shader_ResetStats(void) { memset(&stats, 0, sizeof(stats)); }
 
 void Shader_SetInt(GLuint program, const char *name, int value) {
-  glUniform1i(glGetUniformLocation(program, name), value);
+  Shader_UniformInt(Shader_GetUniform(program, name), value);
 }
 void Shader_SetFloat(GLuint program, const char *name, float value) {
-  glUniform1f(glGetUniformLocation(program, name), value);
+  Shader_UniformFloat(Shader_GetUniform(program, name), value);
 }
 void Shader_SetVec3(GLuint program, const char *name, float x, float y,
                     float z) {
-  glUniform3f(glGetUniformLocation(program, name), x, y, z);
+  Shader_UniformVec3(Shader_GetUniform(program, name), x, y, z);
 }
 
 void Shader_SetVec4(GLuint program, const char *name, float x, float y, float z,
                     float w) {
-  glUniform4f(glGetUniformLocation(program, name), x, y, z, w);
+  Shader_UniformVec4(Shader_GetUniform(program, name), x, y, z, w);
+}
+
+void Shader_SetMat3(GLuint program, const char *name, const float *value) {
+  Shader_UniformMat3(Shader_GetUniform(program, name), value);
 }
 
 void Shader_SetMat4(GLuint program, const char *name, const float *value) {
-  glUniformMatrix4fv(glGetUniformLocation(program, name), 1, GL_FALSE, value);
+  Shader_UniformMat4(Shader_GetUniform(program, name), value);
 }
@@ -3,7 +3,43 @@
 
 #include "../core/window.h" // For GL types
 
+// Pre-resolved uniform handle from Shader_GetUniform. NULL when the uniform
+// is not active in the program; setting a NULL handle is a no-op.
+typedef struct ShaderUniformSlot *ShaderUniform;
+
+typedef struct {
+  int uploads;  // glUniform* calls issued
+  int filtered; // sets skipped because the value was unchanged
+} ShaderStats;
+
+// Feature bits for shader permutations. Each set bit is injected as a
+// #define (DIFFUSE_MAP, NORMAL_MAP, INSTANCED, IMPOSTOR, IMPOSTOR_CAPTURE)
+// after the #version line.
+#define SHADER_FEATURE_DIFFUSE_MAP (1u << 0)
+#define SHADER_FEATURE_NORMAL_MAP (1u << 1)
+#define SHADER_FEATURE_INSTANCED (1u << 2)
+#define SHADER_FEATURE_IMPOSTOR (1u << 3)         // camera facing atlas quads
+#define SHADER_FEATURE_IMPOSTOR_CAPTURE (1u << 4) // renders into the atlas
+#define SHADER_FEATURE_COUNT 5
+#define SHADER_VARIANT_COUNT (1 << SHADER_FEATURE_COUNT)
+
+typedef void (*ShaderSetupFn)(GLuint program);
+
+// Permutations of one vertex/fragment pair, compiled on first request.
+// setup runs once on every new program (block bindings, samplers).
+typedef struct {
+  const char *vertPath;
+  const char *fragPath;
+  ShaderSetupFn setup;
+  GLuint programs[SHADER_VARIANT_COUNT];
+} ShaderVariants;
+
 GLuint Shader_Create(const char *vertPath, const char *fragPath);
+GLuint Shader_CreateVariant(const char *vertPath, const char *fragPath,
+                            unsigned int features);
+void ShaderVariants_Init(ShaderVariants *variants, const char *vertPath,
+                         const char *fragPath, ShaderSetupFn setup);
+GLuint ShaderVariants_Get(ShaderVariants *variants, unsigned int features);
 void Shader_Use(GLuint program);
 void Shader_SetInt(GLuint program, const char *name, int value);
 void Shader_SetFloat(GLuint program, const char *name, float value);
@@ -11,6 +47,21 @@ void Shader_SetVec3(GLuint program, const char *name, float x, float y,
                     float z);
 void Shader_SetVec4(GLuint program, const char *name, float x, float y, float z,
                     float w);
+void Shader_SetMat3(GLuint program, const char *name, const float *value);
 void Shader_SetMat4(GLuint program, const char *name, const float *value);
 
+// Handle based setters skip the name lookup. Like the name based ones they
+// affect the currently used program and only upload changed values.
+ShaderUniform Shader_GetUniform(GLuint program, const char *name);
+void Shader_UniformInt(ShaderUniform u, int value);
+void Shader_UniformFloat(ShaderUniform u, float value);
+void Shader_UniformVec2(ShaderUniform u, float x, float y);
+void Shader_UniformVec3(ShaderUniform u, float x, float y, float z);
+void Shader_UniformVec4(ShaderUniform u, float x, float y, float z, float w);
+void Shader_UniformMat3(ShaderUniform u, const float *value);
+void Shader_UniformMat4(ShaderUniform u, const float *value);
+
+ShaderStats Shader_GetStats(void);
+void Shader_ResetStats(void);
+
 #endif
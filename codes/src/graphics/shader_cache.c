@@ -0,0 +1,148 @@
+#include "shader_cache.h"
+#include "../utils/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint32_t binaryFormat;
+  uint32_t binaryLength;
+} ShaderCacheHeader;
+
+static const char SHADER_CACHE_MAGIC[4] = {'S', 'J', 'P', 'C'};
+
+static void cachePathFor(const char *vertPath, const char *fragPath,
+                         unsigned int features, char *out, size_t outSize) {
+  const char *fragName = strrchr(fragPath, '/');
+  fragName = fragName ? fragName + 1 : fragPath;
+  if (features)
+    snprintf(out, outSize, "%s+%s.%x.progcache", vertPath, fragName,
+             features);
+  else
+    snprintf(out, outSize, "%s+%s.progcache", vertPath, fragName);
+}
+
+int ShaderCache_IsSupported(void) {
+  static int supported = -1;
+  if (supported < 0) {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    supported = formats > 0;
+  }
+  return supported;
+}
+
+// FNV-1a over a string including its terminator, so "ab"+"c" != "a"+"bc"
+static uint64_t hashString(uint64_t h, const char *s) {
+  if (!s)
+    s = "";
+  do {
+    h = (h ^ (unsigned char)*s) * 1099511628211ull;
+  } while (*s++);
+  return h;
+}
+
+uint64_t ShaderCache_Key(const char *defines, const char *vertSource,
+                         const char *fragSource) {
+  uint64_t h = 14695981039346656037ull;
+  h = hashString(h, defines);
+  h = hashString(h, vertSource);
+  h = hashString(h, fragSource);
+  h = hashString(h, (const char *)glGetString(GL_VENDOR));
+  h = hashString(h, (const char *)glGetString(GL_RENDERER));
+  h = hashString(h, (const char *)glGetString(GL_VERSION));
+  return h;
+}
+
+GLuint ShaderCache_Load(const char *vertPath, const char *fragPath,
+                        unsigned int features, uint64_t key) {
+  if (!ShaderCache_IsSupported())
+    return 0;
+
+  char cachePath[1024];
+  cachePathFor(vertPath, fragPath, features, cachePath, sizeof(cachePath));
+  FILE *f = fopen(cachePath, "rb");
+  if (!f)
+    return 0;
+
+  ShaderCacheHeader h;
+  void *binary = NULL;
+  int ok = fread(&h, sizeof(h), 1, f) == 1 &&
+           memcmp(h.magic, SHADER_CACHE_MAGIC, 4) == 0 &&
+           h.version == SHADER_CACHE_VERSION && h.key == key &&
+           h.binaryLength > 0;
+  if (ok) {
+    binary = malloc(h.binaryLength);
+    ok = fread(binary, 1, h.binaryLength, f) == h.binaryLength;
+  }
+  fclose(f);
+  if (!ok) {
+    free(binary);
+    return 0;
+  }
+
+  GLuint prog = glCreateProgram();
+  glProgramBinary(prog, (GLenum)h.binaryFormat, binary,
+                  (GLsizei)h.binaryLength);
+  free(binary);
+
+  // Drivers may reject binaries from an older build of themselves
+  GLint linked = GL_FALSE;
+  glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    Log_Warn("ShaderCache: driver rejected %s, recompiling", cachePath);
+    glDeleteProgram(prog);
+    return 0;
+  }
+  return prog;
+}
+
+int ShaderCache_Store(const char *vertPath, const char *fragPath,
+                      unsigned int features, uint64_t key, GLuint prog) {
+  if (!ShaderCache_IsSupported())
+    return 0;
+
+  GLint length = 0;
+  glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return 0;
+  void *binary = malloc((size_t)length);
+  GLenum format = 0;
+  GLsizei written = 0;
+  glGetProgramBinary(prog, length, &written, &format, binary);
+  if (written <= 0) {
+    free(binary);
+    return 0;
+  }
+
+  ShaderCacheHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, SHADER_CACHE_MAGIC, 4);
+  h.version = SHADER_CACHE_VERSION;
+  h.key = key;
+  h.binaryFormat = (uint32_t)format;
+  h.binaryLength = (uint32_t)written;
+
+  // Same temp file + rename scheme as the mesh cache
+  char cachePath[1024], tmpPath[1040];
+  cachePathFor(vertPath, fragPath, features, cachePath, sizeof(cachePath));
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", cachePath);
+
+  FILE *f = fopen(tmpPath, "wb");
+  int ok = f != NULL;
+  if (ok) {
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+         fwrite(binary, 1, (size_t)written, f) == (size_t)written;
+    ok = (fclose(f) == 0) && ok;
+  }
+  free(binary);
+  if (!ok || rename(tmpPath, cachePath) != 0) {
+    remove(tmpPath);
+    Log_Warn("ShaderCache: could not write %s", cachePath);
+    return 0;
+  }
+  return 1;
+}
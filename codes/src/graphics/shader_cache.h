@@ -0,0 +1,26 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "../core/window.h"
+#include <stdint.h>
+
+// Linked program binaries stored next to the vertex shader as
+// "<vertPath>+<frag file name>[.<features>].progcache". The key hashes the
+// injected defines, both sources and the driver vendor/renderer/version, so
+// edits or driver updates simply miss. Bump SHADER_CACHE_VERSION if the file layout changes.
+#define SHADER_CACHE_VERSION 1
+
+// 0 when the driver offers no program binary formats (cache disabled)
+int ShaderCache_IsSupported(void);
+uint64_t ShaderCache_Key(const char *defines, const char *vertSource,
+                         const char *fragSource);
+// Returns a linked program, or 0 on a miss or if the driver rejects the
+// binary. The caller then compiles from source.
+GLuint ShaderCache_Load(const char *vertPath, const char *fragPath,
+                        unsigned int features, uint64_t key);
+// prog must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+// Failures are not fatal.
+int ShaderCache_Store(const char *vertPath, const char *fragPath,
+                      unsigned int features, uint64_t key, GLuint prog);
+
+#endif
@@ -0,0 +1,207 @@
+#include "static_batch.h"
+#include "render_stats.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void StaticBatch_Init(StaticBatch *batch, Mesh *mesh) {
+  memset(batch, 0, sizeof(StaticBatch));
+  batch->mesh = mesh;
+}
+
+static void push(float **list, int *count, int *capacity, mat4 model) {
+  if (*count == *capacity) {
+    *capacity = *capacity ? *capacity * 2 : 16;
+    *list = (float *)realloc(*list, *capacity * 16 * sizeof(float));
+  }
+  memcpy(*list + *count * 16, model.m, 16 * sizeof(float));
+  (*count)++;
+}
+
+void StaticBatch_Add(StaticBatch *batch, mat4 model, int flags) {
+  if (flags == BATCH_ALL_PASSES)
+    push(&batch->allPasses, &batch->allPassesCount, &batch->allPassesCapacity,
+         model);
+  else
+    push(&batch->skipReflection, &batch->skipReflectionCount,
+         &batch->skipReflectionCapacity, model);
+}
+
+void StaticBatch_AddSymmetric(StaticBatch *batch, float offsetX, float y,
+                              float offsetZ, int flags) {
+  float xs[4] = {-offsetX, offsetX, -offsetX, offsetX}; // Left/Right
+  float zs[4] = {offsetZ, offsetZ, -offsetZ, -offsetZ}; // Near/Far
+  for (int i = 0; i < 4; i++) {
+    mat4 model = identity();
+    model.m[12] = xs[i];
+    model.m[13] = y;
+    model.m[14] = zs[i];
+    StaticBatch_Add(batch, model, flags);
+  }
+}
+
+// Centered on the box around the instance spheres, grown to reach each one
+static void computeBounds(StaticBatch *batch) {
+  float lo[3], hi[3];
+  for (int k = 0; k < 3; k++) {
+    lo[k] = batch->spheres[k] - batch->spheres[3];
+    hi[k] = batch->spheres[k] + batch->spheres[3];
+  }
+  for (int i = 1; i < batch->count; i++) {
+    const float *s = batch->spheres + i * 4;
+    for (int k = 0; k < 3; k++) {
+      lo[k] = fminf(lo[k], s[k] - s[3]);
+      hi[k] = fmaxf(hi[k], s[k] + s[3]);
+    }
+  }
+  float radius = 0.0f;
+  for (int k = 0; k < 3; k++)
+    batch->bounds[k] = 0.5f * (lo[k] + hi[k]);
+  for (int i = 0; i < batch->count; i++) {
+    const float *s = batch->spheres + i * 4;
+    float dx = s[0] - batch->bounds[0];
+    float dy = s[1] - batch->bounds[1];
+    float dz = s[2] - batch->bounds[2];
+    radius = fmaxf(radius, sqrtf(dx * dx + dy * dy + dz * dz) + s[3]);
+  }
+  batch->bounds[3] = radius;
+}
+
+void StaticBatch_Build(StaticBatch *batch) {
+  batch->reflectionCount = batch->allPassesCount;
+  batch->count = batch->allPassesCount + batch->skipReflectionCount;
+  if (batch->count > 0) {
+    size_t bytes = batch->count * MESH_INSTANCE_FLOATS * sizeof(float);
+    batch->instances = (float *)malloc(bytes);
+    batch->visible = (float *)malloc(bytes);
+    batch->lods = (unsigned char *)malloc(batch->count);
+    batch->spheres = (float *)malloc(batch->count * 4 * sizeof(float));
+    // Normal matrices are computed here once instead of per vertex
+    for (int i = 0; i < batch->count; i++) {
+      mat4 model;
+      if (i < batch->allPassesCount)
+        memcpy(model.m, batch->allPasses + i * 16, sizeof(model.m));
+      else
+        memcpy(model.m,
+               batch->skipReflection + (i - batch->allPassesCount) * 16,
+               sizeof(model.m));
+      Mesh_PackInstance(batch->mesh, model,
+                        batch->instances + i * MESH_INSTANCE_FLOATS);
+      Culling_TransformSphere(batch->mesh, model.m, batch->spheres + i * 4,
+                              batch->spheres + i * 4 + 3);
+    }
+    computeBounds(batch);
+    Mesh_SetupInstanced(batch->mesh, batch->count, batch->instances);
+    batch->uploaded = batch->count;
+  }
+
+  free(batch->allPasses);
+  free(batch->skipReflection);
+  batch->allPasses = batch->skipReflection = NULL;
+  batch->allPassesCount = batch->skipReflectionCount = 0;
+  batch->allPassesCapacity = batch->skipReflectionCapacity = 0;
+}
+
+// Whether the instance is left to the impostor for this view
+static int isFar(const StaticBatch *batch, const LodView *view,
+                 const float *sphere) {
+  if (batch->impostorDistance <= 0.0f)
+    return 0;
+  float dx = sphere[0] - view->position[0];
+  float dy = sphere[1] - view->position[1];
+  float dz = sphere[2] - view->position[2];
+  return sqrtf(dx * dx + dy * dy + dz * dz) - sphere[3] >=
+         batch->impostorDistance;
+}
+
+void StaticBatch_Draw(StaticBatch *batch, const Frustum *frustum,
+                      const Occlusion *occlusion, int reflectionPass,
+                      const LodView *view) {
+  int candidates = reflectionPass ? batch->reflectionCount : batch->count;
+  if (candidates == 0)
+    return;
+
+  int levelCount[MESH_MAX_LODS] = {0};
+  int visibleCount = 0;
+  int farCount = 0;
+  int occludedCount = 0;
+  for (int i = 0; i < candidates; i++) {
+    const float *sphere = batch->spheres + i * 4;
+    batch->lods[i] = 0xFF;
+    if (!Frustum_TestSphere(frustum, sphere, sphere[3]))
+      continue;
+    if (!Occlusion_TestSphere(occlusion, sphere, sphere[3])) {
+      occludedCount++;
+      continue;
+    }
+    if (isFar(batch, view, sphere)) {
+      farCount++;
+      continue;
+    }
+    int lod = Mesh_SelectLod(batch->mesh, view, sphere, sphere[3]);
+    batch->lods[i] = (unsigned char)lod;
+    levelCount[lod]++;
+    visibleCount++;
+  }
+  // Impostor instances count as visible here and are not counted again
+  RenderStats_AddCulling(visibleCount + farCount,
+                         candidates - visibleCount - farCount);
+  RenderStats_AddOcclusion(occludedCount);
+  if (visibleCount == 0)
+    return;
+
+  int singleLevel = -1;
+  for (int lod = 0; lod < MESH_MAX_LODS; lod++)
+    if (levelCount[lod] == visibleCount)
+      singleLevel = lod;
+  if (singleLevel >= 0 && visibleCount == candidates) {
+    // The visible set is a prefix of the full list; restore the full buffer
+    // once instead of re-uploading it every pass
+    if (batch->uploaded != batch->count) {
+      Mesh_UpdateInstances(batch->mesh, batch->count, batch->instances);
+      batch->uploaded = batch->count;
+    }
+    Mesh_DrawInstancedLod(batch->mesh, singleLevel, 0, visibleCount);
+    return;
+  }
+
+  // Compact the visible instances grouped by level, keeping their original
+  // order within a level
+  int first[MESH_MAX_LODS];
+  int next[MESH_MAX_LODS];
+  for (int lod = 0, n = 0; lod < MESH_MAX_LODS; lod++) {
+    first[lod] = next[lod] = n;
+    n += levelCount[lod];
+  }
+  for (int i = 0; i < candidates; i++) {
+    if (batch->lods[i] == 0xFF)
+      continue;
+    memcpy(batch->visible + next[batch->lods[i]]++ * MESH_INSTANCE_FLOATS,
+           batch->instances + i * MESH_INSTANCE_FLOATS,
+           MESH_INSTANCE_FLOATS * sizeof(float));
+  }
+  Mesh_UpdateInstances(batch->mesh, visibleCount, batch->visible);
+  batch->uploaded = -1;
+  for (int lod = 0; lod < MESH_MAX_LODS; lod++)
+    if (levelCount[lod] > 0)
+      Mesh_DrawInstancedLod(batch->mesh, lod, first[lod], levelCount[lod]);
+}
+
+int StaticBatch_CollectImpostors(const StaticBatch *batch,
+                                 const Frustum *frustum,
+                                 const Occlusion *occlusion,
+                                 int reflectionPass, const LodView *view,
+                                 float *out) {
+  int candidates = reflectionPass ? batch->reflectionCount : batch->count;
+  int count = 0;
+  for (int i = 0; i < candidates; i++) {
+    const float *sphere = batch->spheres + i * 4;
+    if (isFar(batch, view, sphere) &&
+        Frustum_TestSphere(frustum, sphere, sphere[3]) &&
+        Occlusion_TestSphere(occlusion, sphere, sphere[3]))
+      memcpy(out + count++ * MESH_INSTANCE_FLOATS,
+             batch->instances + i * MESH_INSTANCE_FLOATS,
+             MESH_INSTANCE_FLOATS * sizeof(float));
+  }
+  return count;
+}
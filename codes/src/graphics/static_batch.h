@@ -0,0 +1,60 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include "../utils/math_utils.h"
+#include "culling.h"
+#include "mesh.h"
+
+// Placement flags for StaticBatch_Add
+#define BATCH_ALL_PASSES 1      // drawn in the reflection pass as well
+#define BATCH_SKIP_REFLECTION 0 // only drawn in refraction and main passes
+
+// Placements of one never-moving mesh, collected at startup and uploaded as
+// the mesh's instance buffer so the whole set costs one instanced draw.
+// Instances visible in the reflection pass are stored first, so that pass
+// simply considers a shorter prefix of the same list. Each draw culls the
+// instances against the pass frustum, picks a detail level per instance and
+// uploads only the visible ones, grouped by level (one draw per level).
+// With an impostorDistance, instances at least that far away are skipped
+// and left to StaticBatch_CollectImpostors.
+typedef struct {
+  Mesh *mesh;
+  int count;
+  int reflectionCount;
+  float *instances; // MESH_INSTANCE_FLOATS records, reflection prefix first
+  float *spheres;   // world space bounding sphere per instance (x, y, z, r)
+  float bounds[4];  // sphere enclosing every instance
+  float *visible;   // scratch for the compacted records
+  unsigned char *lods; // scratch: level per candidate, 0xFF when culled
+  int uploaded;    // instances currently in the GL buffer, -1 if compacted
+  float impostorDistance; // from the eye to the sphere, 0 disables
+  // Staging while placements are added, released by StaticBatch_Build
+  float *allPasses;
+  float *skipReflection;
+  int allPassesCount;
+  int skipReflectionCount;
+  int allPassesCapacity;
+  int skipReflectionCapacity;
+} StaticBatch;
+
+void StaticBatch_Init(StaticBatch *batch, Mesh *mesh);
+void StaticBatch_Add(StaticBatch *batch, mat4 model, int flags);
+// Adds the 4 mirrored placements (+-x, y, +-z) with no rotation or scale
+void StaticBatch_AddSymmetric(StaticBatch *batch, float offsetX, float y,
+                              float offsetZ, int flags);
+// Uploads the instance buffer (via Mesh_SetupInstanced); call once
+void StaticBatch_Build(StaticBatch *batch);
+// Expects a program reading the model matrix from instance attributes 4-7.
+// occlusion may be NULL.
+void StaticBatch_Draw(StaticBatch *batch, const Frustum *frustum,
+                      const Occlusion *occlusion, int reflectionPass,
+                      const LodView *view);
+// Copies the records of the visible instances StaticBatch_Draw skips as far
+// into out (room for count records) and returns how many there are
+int StaticBatch_CollectImpostors(const StaticBatch *batch,
+                                 const Frustum *frustum,
+                                 const Occlusion *occlusion,
+                                 int reflectionPass, const LodView *view,
+                                 float *out);
+
+#endif
@@ -1,4 +1,6 @@
 #include "texture.h"
+#include "gl_state.h"
+#include "../utils/log.h"
 #include <math.h>
 #include <stdlib.h>
 #define STB_IMAGE_IMPLEMENTATION
@@ -58,7 +60,7 @@ GLuint Texture_CreateProceduralNormalMap(int width, int height) {
 
   GLuint textureID;
   glGenTextures(1, &textureID);
-  glBindTexture(GL_TEXTURE_2D, textureID);
+  GLState_BindTexture(0, textureID);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
                GL_UNSIGNED_BYTE, texData);
   glGenerateMipmap(GL_TEXTURE_2D);
@@ -104,7 +106,7 @@ GLuint Texture_CreateNoiseNormalMap(int width, int height) {
 
   GLuint textureID;
   glGenTextures(1, &textureID);
-  glBindTexture(GL_TEXTURE_2D, textureID);
+  GLState_BindTexture(0, textureID);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
                GL_UNSIGNED_BYTE, texData);
   glGenerateMipmap(GL_TEXTURE_2D);
@@ -166,7 +168,7 @@ GLuint Texture_CreateGrassTexture(int width, int height) {
 
   GLuint textureID;
   glGenTextures(1, &textureID);
-  glBindTexture(GL_TEXTURE_2D, textureID);
+  GLState_BindTexture(0, textureID);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
                GL_UNSIGNED_BYTE, texData);
   glGenerateMipmap(GL_TEXTURE_2D);
@@ -182,42 +184,61 @@ GLuint Texture_CreateGrassTexture(int width, int height) {
   return textureID;
 }
 
-GLuint Texture_Load(const char *path) {
-  int width, height, nrChannels;
+// Decodes an image file into CPU memory. Safe to call from worker threads;
+// the GL upload happens separately in Texture_Upload.
+int Texture_Decode(const char *path, TextureData *out) {
   // Flip vertically because OpenGL expects 0.0 at bottom
   // User reported texture is wrong, likely double flipped or not needed for
   // this model
-  stbi_set_flip_vertically_on_load(0);
-  unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-  if (data) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    GLenum format;
-    if (nrChannels == 1)
-      format = GL_RED;
-    else if (nrChannels == 3)
-      format = GL_RGB;
-    else if (nrChannels == 4)
-      format = GL_RGBA;
-    else
-      format = GL_RGB;
-
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-    return textureID;
-  } else {
-    printf("Texture failed to load at path: %s\n", path);
+  stbi_set_flip_vertically_on_load_thread(0);
+  out->pixels = stbi_load(path, &out->width, &out->height, &out->channels, 0);
+  if (!out->pixels) {
+    Log_Error("Texture failed to load at path: %s", path);
     return 0;
   }
+  return 1;
+}
+
+void TextureData_Free(TextureData *data) {
+  stbi_image_free(data->pixels);
+  data->pixels = NULL;
+}
+
+GLuint Texture_Upload(const TextureData *data) {
+  if (!data->pixels)
+    return 0;
+
+  GLuint textureID;
+  glGenTextures(1, &textureID);
+  GLState_BindTexture(0, textureID);
+
+  GLenum format;
+  if (data->channels == 1)
+    format = GL_RED;
+  else if (data->channels == 3)
+    format = GL_RGB;
+  else if (data->channels == 4)
+    format = GL_RGBA;
+  else
+    format = GL_RGB;
+
+  glTexImage2D(GL_TEXTURE_2D, 0, format, data->width, data->height, 0, format,
+               GL_UNSIGNED_BYTE, data->pixels);
+  glGenerateMipmap(GL_TEXTURE_2D);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  return textureID;
+}
+
+GLuint Texture_Load(const char *path) {
+  TextureData data;
+  if (!Texture_Decode(path, &data))
+    return 0;
+  GLuint textureID = Texture_Upload(&data);
+  TextureData_Free(&data);
+  return textureID;
 }
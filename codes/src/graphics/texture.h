@@ -3,9 +3,18 @@
 
 #include "../core/window.h"
 
+// Decoded image waiting for upload
+typedef struct {
+  unsigned char *pixels;
+  int width, height, channels;
+} TextureData;
+
 GLuint Texture_CreateProceduralNormalMap(int width, int height);
 GLuint Texture_CreateNoiseNormalMap(int width, int height);
 GLuint Texture_CreateGrassTexture(int width, int height);
 GLuint Texture_Load(const char *path);
+int Texture_Decode(const char *path, TextureData *out);
+GLuint Texture_Upload(const TextureData *data);
+void TextureData_Free(TextureData *data);
 
 #endif
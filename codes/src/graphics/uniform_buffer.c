@@ -0,0 +1,40 @@
+#include "uniform_buffer.h"
+
+UniformBuffer UniformBuffer_Create(GLuint binding, GLsizeiptr blockSize,
+                                   int slotCount) {
+  UniformBuffer ubo;
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  ubo.binding = binding;
+  ubo.blockSize = blockSize;
+  ubo.stride = (blockSize + alignment - 1) / alignment * alignment;
+  ubo.slotCount = slotCount;
+
+  glGenBuffers(1, &ubo.buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo.buffer);
+  glBufferData(GL_UNIFORM_BUFFER, ubo.stride * slotCount, NULL,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, ubo.buffer, 0, blockSize);
+  return ubo;
+}
+
+void UniformBuffer_Update(UniformBuffer *ubo, int slot, const void *data) {
+  GLintptr offset = ubo->stride * slot;
+  glBindBuffer(GL_UNIFORM_BUFFER, ubo->buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, ubo->blockSize, data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferRange(GL_UNIFORM_BUFFER, ubo->binding, ubo->buffer, offset,
+                    ubo->blockSize);
+}
+
+static void bindBlock(GLuint program, const char *name, GLuint binding) {
+  GLuint index = glGetUniformBlockIndex(program, name);
+  if (index != GL_INVALID_INDEX)
+    glUniformBlockBinding(program, index, binding);
+}
+
+void UniformBuffer_BindBlocks(GLuint program) {
+  bindBlock(program, "Camera", UBO_BINDING_CAMERA);
+  bindBlock(program, "Lighting", UBO_BINDING_LIGHTING);
+}
@@ -0,0 +1,48 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include "../core/window.h"
+
+// Binding points shared by every program (see UniformBuffer_BindBlocks)
+#define UBO_BINDING_CAMERA 0
+#define UBO_BINDING_LIGHTING 1
+
+// std140 layout of "uniform Camera", updated once per render pass
+typedef struct {
+  float view[16];
+  float projection[16];
+  float viewPos[3];
+  float pad0;
+  float plane[4]; // clip plane
+} CameraBlock;
+
+// std140 layout of "uniform Lighting", shared by the whole frame
+typedef struct {
+  float sunDir[3];
+  float pad0;
+  float sunColor[3];
+  float pad1;
+  float skyColor[3];
+  float pad2;
+  float groundColor[3];
+  float pad3;
+} LightingBlock;
+
+// A buffer holding slotCount copies of one block, each aligned to
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT so a slot can be bound as a range
+typedef struct {
+  GLuint buffer;
+  GLuint binding;
+  GLsizeiptr blockSize;
+  GLsizeiptr stride;
+  int slotCount;
+} UniformBuffer;
+
+UniformBuffer UniformBuffer_Create(GLuint binding, GLsizeiptr blockSize,
+                                   int slotCount);
+// Uploads data into the slot and binds that range to the buffer's binding
+void UniformBuffer_Update(UniformBuffer *ubo, int slot, const void *data);
+// Connects the program's Camera/Lighting blocks (if used) to their bindings
+void UniformBuffer_BindBlocks(GLuint program);
+
+#endif
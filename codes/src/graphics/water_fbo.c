@@ -1,5 +1,6 @@
 #include "water_fbo.h"
-#include <stdio.h>
+#include "gl_state.h"
+#include "../utils/log.h"
 #include <stdlib.h>
 
 // Constants for FBO sizes
@@ -12,7 +13,7 @@
 static GLuint createFrameBuffer() {
   GLuint frameBuffer;
   glGenFramebuffers(1, &frameBuffer);
-  glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+  GLState_BindFramebuffer(frameBuffer);
   glDrawBuffer(GL_COLOR_ATTACHMENT0);
   return frameBuffer;
 }
@@ -20,7 +21,7 @@ static GLuint createFrameBuffer() {
 static GLuint createTextureAttachment(int width, int height) {
   GLuint texture;
   glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  GLState_BindTexture(0, texture);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
                GL_UNSIGNED_BYTE, NULL);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -34,7 +35,7 @@ static GLuint createTextureAttachment(int width, int height) {
 static GLuint createDepthTextureAttachment(int width, int height) {
   GLuint texture;
   glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  GLState_BindTexture(0, texture);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, width, height, 0,
                GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -61,9 +62,9 @@ static void initialiseReflectionFrameBuffer(WaterFrameBuffers *fbos) {
       createDepthBufferAttachment(REFLECTION_WIDTH, REFLECTION_HEIGHT);
 
   if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    printf("ERROR::FRAMEBUFFER:: Reflection Framebuffer is not complete!\n");
+    Log_Error("WaterFBO: reflection framebuffer is not complete");
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  GLState_BindFramebuffer(0);
 }
 
 static void initialiseRefractionFrameBuffer(WaterFrameBuffers *fbos) {
@@ -74,9 +75,9 @@ static void initialiseRefractionFrameBuffer(WaterFrameBuffers *fbos) {
       createDepthTextureAttachment(REFRACTION_WIDTH, REFRACTION_HEIGHT);
 
   if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    printf("ERROR::FRAMEBUFFER:: Refraction Framebuffer is not complete!\n");
+    Log_Error("WaterFBO: refraction framebuffer is not complete");
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  GLState_BindFramebuffer(0);
 }
 
 WaterFrameBuffers WaterFBO_Init(int width, int height) {
@@ -98,19 +99,19 @@ void WaterFBO_CleanUp(WaterFrameBuffers *fbos) {
 
 void WaterFBO_BindReflectionFrameBuffer(WaterFrameBuffers *fbos, int width,
                                         int height) {
-  glBindTexture(GL_TEXTURE_2D, 0); // Make sure texture isn't bound
-  glBindFramebuffer(GL_FRAMEBUFFER, fbos->reflectionFrameBuffer);
-  glViewport(0, 0, REFLECTION_WIDTH, REFLECTION_HEIGHT);
+  GLState_BindTexture(0, 0); // Make sure texture isn't bound
+  GLState_BindFramebuffer(fbos->reflectionFrameBuffer);
+  GLState_Viewport(0, 0, REFLECTION_WIDTH, REFLECTION_HEIGHT);
 }
 
 void WaterFBO_BindRefractionFrameBuffer(WaterFrameBuffers *fbos, int width,
                                         int height) {
-  glBindTexture(GL_TEXTURE_2D, 0); // Make sure texture isn't bound
-  glBindFramebuffer(GL_FRAMEBUFFER, fbos->refractionFrameBuffer);
-  glViewport(0, 0, REFRACTION_WIDTH, REFRACTION_HEIGHT);
+  GLState_BindTexture(0, 0); // Make sure texture isn't bound
+  GLState_BindFramebuffer(fbos->refractionFrameBuffer);
+  GLState_Viewport(0, 0, REFRACTION_WIDTH, REFRACTION_HEIGHT);
 }
 
 void WaterFBO_UnbindCurrentFrameBuffer(int width, int height) {
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glViewport(0, 0, width, height);
+  GLState_BindFramebuffer(0);
+  GLState_Viewport(0, 0, width, height);
 }
@@ -1,20 +1,28 @@
 #include "config.h"
+#include "core/bench.h"
 #include "core/camera.h"
 #include "core/input.h"
 #include "core/window.h"
+#include "graphics/asset_loader.h"
+#include "graphics/culling.h"
+#include "graphics/gl_state.h"
+#include "graphics/impostor.h"
 #include "graphics/mesh.h"
+#include "graphics/occlusion.h"
+#include "graphics/overlay.h"
+#include "graphics/profiler.h"
+#include "graphics/render_queue.h"
+#include "graphics/render_stats.h"
 #include "graphics/shader.h"
+#include "graphics/static_batch.h"
 #include "graphics/texture.h"
+#include "graphics/uniform_buffer.h"
 #include "graphics/water_fbo.h"
+#include "utils/log.h"
 #include "utils/math_utils.h"
 #include <stdio.h>
 #include <stdlib.h>
-
-// Helper to store matrix
-void storeMatrix(float *buffer, int index, mat4 m) {
-  for (int i = 0; i < 16; i++)
-    buffer[index * 16 + i] = m.m[i];
-}
+#include <string.h>
 
 /*
  *
@@ -88,6 +96,7 @@ void storeMatrix(float *buffer, int index, mat4 m) {
 #define FLOWER_SPACING_Z 7.0f
 #define FLOWER_Y_OFFSET 0.0f // Set if model is on above or below ground
 #define FLOWER_SCALE 2.0f
+#define FLOWER_IMPOSTOR_DISTANCE 30.0f // farther flowers are drawn as quads
 
 #define GAZEBO_OFFSET_X 10.0f
 #define GAZEBO_OFFSET_Z 5.0f
@@ -124,6 +133,7 @@ void storeMatrix(float *buffer, int index, mat4 m) {
 #define HEDGE_SPACING_Z 16.0f
 #define HEDGE_SCALE 0.05f
 #define HEDGE_Y_OFFSET -1.0f
+#define HEDGE_IMPOSTOR_DISTANCE 60.0f // farther hedges are drawn as quads
 
 #define FENCE_WIDTH 0.2f
 #define FENCE_HEIGHT 9.0f
@@ -186,37 +196,33 @@ float GetWalkableWidth(float z) {
   return WORLD_LIMIT_X;
 }
 
-// Draws a mesh at a specific position with no rotation/scaling (Identity basis)
-void DrawMeshSimple(GLuint shader, Mesh *mesh, float x, float y, float z) {
-  mat4 model = identity();
-  model.m[12] = x;
-  model.m[13] = y;
-  model.m[14] = z;
-  Shader_SetMat4(shader, "model", model.m);
-  Mesh_Draw(mesh);
+// Queues a model and its associated texture on the background loader;
+// meshFlags are MESH_LOAD_* options
+void LoadModelWithTexture(AssetLoader *loader, const char *modelPath,
+                          const char *texturePath, unsigned int meshFlags,
+                          Mesh *outMesh, GLuint *outTexture) {
+  AssetLoader_AddModel(loader, modelPath, meshFlags, outMesh);
+  AssetLoader_AddTexture(loader, texturePath, outTexture);
 }
 
-// Draws 4 symmetric instances of a mesh:
-// (x, y, z), (-x, y, z), (x, y, -z), (-x, y, -z)
-void DrawSymmetricLayer(GLuint shader, Mesh *mesh, float offsetX, float y,
-                        float offsetZ) {
-  DrawMeshSimple(shader, mesh, -offsetX, y, offsetZ);  // Left Near
-  DrawMeshSimple(shader, mesh, offsetX, y, offsetZ);   // Right Near
-  DrawMeshSimple(shader, mesh, -offsetX, y, -offsetZ); // Left Far
-  DrawMeshSimple(shader, mesh, offsetX, y, -offsetZ);  // Right Far
-  DrawMeshSimple(shader, mesh, offsetX, y, -offsetZ);  // Right Far
+// Runs once on each surface shader variant when it is first compiled
+void SetupSurfaceShader(GLuint program) {
+  UniformBuffer_BindBlocks(program);
+  Shader_Use(program);
+  Shader_SetInt(program, "normalMap", 0);  // GL_TEXTURE0
+  Shader_SetInt(program, "diffuseMap", 1); // GL_TEXTURE1
 }
 
-// Loads a model and its associated texture
-void LoadModelWithTexture(const char *modelPath, const char *texturePath,
-                          Mesh *outMesh, GLuint *outTexture) {
-  *outMesh = Mesh_LoadModel(modelPath);
-  *outTexture = Texture_Load(texturePath);
-}
+int main(int argc, char **argv) {
+  Bench bench;
+  if (!Bench_ParseArgs(&bench, argc, argv))
+    return -1;
+  Log_Init(NULL);
 
-int main() {
   // 1. Init Window
-  GLFWwindow *window = initWindow(SCR_WIDTH, SCR_HEIGHT, WINDOW_TITLE);
+  GLFWwindow *window =
+      bench.enabled ? initWindowHeadless(SCR_WIDTH, SCR_HEIGHT, WINDOW_TITLE)
+                    : initWindow(SCR_WIDTH, SCR_HEIGHT, WINDOW_TITLE);
   if (!window)
     return -1;
 
@@ -230,79 +236,127 @@ int main() {
   Camera_Init(&camera, startPos, up, -90.0f, 0.0f);
 
   // 4. Load Resources
-  GLuint shader = Shader_Create("shaders/floor.vert", "shaders/floor.frag");
-  GLuint instancedShader =
-      Shader_Create("shaders/instanced.vert", "shaders/floor.frag");
-  GLuint skyboxShader =
-      Shader_Create("shaders/skybox.vert", "shaders/skybox.frag");
-  GLuint grassShader =
-      Shader_Create("shaders/grass.vert", "shaders/grass.frag");
-  GLuint godrayShader =
-      Shader_Create("shaders/godray.vert", "shaders/godray.frag");
-  GLuint normalMap = Texture_CreateProceduralNormalMap(512, 512);
-  GLuint asphaltNormalMap = Texture_CreateNoiseNormalMap(512, 512);
-  GLuint grassTexture = Texture_CreateGrassTexture(512, 512);
-
-  // Create Cube Mesh for pathways
-  Mesh floorMesh = Mesh_CreateCube(FLOOR_WIDTH, FLOOR_HEIGHT, FLOOR_DEPTH);
-
-  // Create Road Mesh (Asphalt)
-  Mesh roadMesh = Mesh_CreateCube(ROAD_WIDTH, ROAD_HEIGHT, ROAD_DEPTH);
-
-  // Create Grass Mesh
-  Mesh grassMesh = Mesh_CreateCube(GRASS_WIDTH, GRASS_HEIGHT, GRASS_DEPTH);
+  // Model parsing and image decoding run on worker threads while the shaders
+  // and procedural assets below are built here; uploads happen in Finish.
+  AssetLoader *loader = AssetLoader_Create(ThreadPool_GetDefault());
 
   // Load Gazebo Model & Texture
   Mesh gazeboMesh;
   GLuint gazeboTexture;
-  LoadModelWithTexture("../materials/gazebo/rgazebo.obj",
-                       "../materials/gazebo/texture_diffuse.png", &gazeboMesh,
-                       &gazeboTexture);
-
-  // Create Border Mesh (Curb)
-  Mesh borderMesh = Mesh_CreateCube(BORDER_WIDTH, BORDER_HEIGHT, BORDER_DEPTH);
+  LoadModelWithTexture(loader, "../materials/gazebo/rgazebo.obj",
+                       "../materials/gazebo/texture_diffuse.png", 0,
+                       &gazeboMesh, &gazeboTexture);
 
-  // Load Bridge Model & Texture
+  // Load Bridge Model & Texture. The bridge, halfpipe and castle are each
+  // drawn once, so they are split into clusters culled on their own.
   Mesh bridgeMesh;
   GLuint bridgeTexture;
-  LoadModelWithTexture("../materials/bridge/bridge.obj",
-                       "../materials/bridge/texture_diffuse.png", &bridgeMesh,
-                       &bridgeTexture);
+  LoadModelWithTexture(loader, "../materials/bridge/bridge.obj",
+                       "../materials/bridge/texture_diffuse.png",
+                       MESH_LOAD_CLUSTERS, &bridgeMesh, &bridgeTexture);
 
   // Load Halfpipe Model & Texture
   Mesh halfpipeMesh;
   GLuint halfpipeTexture;
-  LoadModelWithTexture("../materials/halfpipe/halfpipe.obj",
+  LoadModelWithTexture(loader, "../materials/halfpipe/halfpipe.obj",
                        "../materials/halfpipe/halfpipe_texture.png",
-                       &halfpipeMesh, &halfpipeTexture);
+                       MESH_LOAD_CLUSTERS, &halfpipeMesh, &halfpipeTexture);
 
   // Load Flower Model & Texture
   Mesh flowerMesh;
   GLuint flowerTexture;
-  LoadModelWithTexture("../materials/flower/rflower.obj",
-                       "../materials/flower/shaded.png", &flowerMesh,
+  LoadModelWithTexture(loader, "../materials/flower/rflower.obj",
+                       "../materials/flower/shaded.png", 0, &flowerMesh,
                        &flowerTexture);
 
   // Load White Flower Model & Texture
   Mesh flowerWMesh;
   GLuint flowerWTexture;
-  LoadModelWithTexture("../materials/flower_w/rflower_w_pbr.obj",
-                       "../materials/flower_w/shaded.png", &flowerWMesh,
+  LoadModelWithTexture(loader, "../materials/flower_w/rflower_w_pbr.obj",
+                       "../materials/flower_w/shaded.png", 0, &flowerWMesh,
                        &flowerWTexture);
 
   // Load Skybox Texture
-  GLuint skyboxTexture = Texture_Load(
-      "../materials/sky/Gemini_Generated_Image_ikqh7oikqh7oikqh.png");
-  Mesh skyboxMesh = Mesh_CreateCube(100.0f, 100.0f, 100.0f);
+  GLuint skyboxTexture;
+  AssetLoader_AddTexture(
+      loader, "../materials/sky/Gemini_Generated_Image_ikqh7oikqh7oikqh.png",
+      &skyboxTexture);
 
   // Load Hedge Model & Texture
   Mesh hedgeMesh;
   GLuint hedgeTexture;
   LoadModelWithTexture(
-      "../materials/hedge/source/hedge-obj/rhedgeTextured.obj",
-      "../materials/hedge/source/hedge-obj/hedge-displacement-texture.jpg",
+      loader, "../materials/hedge/source/hedge-obj/rhedgeTextured.obj",
+      "../materials/hedge/source/hedge-obj/hedge-displacement-texture.jpg", 0,
       &hedgeMesh, &hedgeTexture);
 
+  // Load Castle Model & Texture
+  Mesh castleMesh;
+  GLuint castleTexture;
+  LoadModelWithTexture(loader, "../materials/castle/rcastle.obj",
+                       "../materials/castle/texture_diffuse.png",
+                       MESH_LOAD_CLUSTERS, &castleMesh, &castleTexture);
+
+  // Water DUDV map
+  GLuint waterDUDV;
+  AssetLoader_AddTexture(loader, "../materials/water/dudv.png", &waterDUDV);
+
+  // Every lit surface shares floor.vert/floor.frag; texture maps and
+  // instancing are compile-time features instead of runtime branches
+  ShaderVariants surfaceShaders;
+  ShaderVariants_Init(&surfaceShaders, "shaders/floor.vert",
+                      "shaders/floor.frag", SetupSurfaceShader);
+  GLuint texturedShader =
+      ShaderVariants_Get(&surfaceShaders, SHADER_FEATURE_DIFFUSE_MAP);
+  GLuint stoneShader = ShaderVariants_Get(
+      &surfaceShaders, SHADER_FEATURE_INSTANCED | SHADER_FEATURE_NORMAL_MAP);
+  GLuint grassShader = ShaderVariants_Get(
+      &surfaceShaders, SHADER_FEATURE_INSTANCED | SHADER_FEATURE_DIFFUSE_MAP |
+                           SHADER_FEATURE_NORMAL_MAP);
+  GLuint foliageShader = ShaderVariants_Get(
+      &surfaceShaders, SHADER_FEATURE_INSTANCED | SHADER_FEATURE_DIFFUSE_MAP);
+  GLuint plainShader =
+      ShaderVariants_Get(&surfaceShaders, SHADER_FEATURE_INSTANCED);
+  GLuint foliageCaptureShader = ShaderVariants_Get(
+      &surfaceShaders,
+      SHADER_FEATURE_DIFFUSE_MAP | SHADER_FEATURE_IMPOSTOR_CAPTURE);
+  GLuint impostorShader = ShaderVariants_Get(
+      &surfaceShaders, SHADER_FEATURE_INSTANCED | SHADER_FEATURE_IMPOSTOR |
+                           SHADER_FEATURE_DIFFUSE_MAP |
+                           SHADER_FEATURE_NORMAL_MAP);
+  GLuint skyboxShader =
+      Shader_Create("shaders/skybox.vert", "shaders/skybox.frag");
+  GLuint godrayShader =
+      Shader_Create("shaders/godray_instanced.vert", "shaders/godray.frag");
+  GLuint occluderShader =
+      Shader_Create("shaders/occluder.vert", "shaders/occluder.frag");
+  // Camera (per pass) and lighting (per frame) blocks shared by all programs
+  UniformBuffer_BindBlocks(skyboxShader);
+  UniformBuffer_BindBlocks(godrayShader);
+  UniformBuffer_BindBlocks(occluderShader);
+  UniformBuffer cameraUBO =
+      UniformBuffer_Create(UBO_BINDING_CAMERA, sizeof(CameraBlock), 3);
+  UniformBuffer lightingUBO =
+      UniformBuffer_Create(UBO_BINDING_LIGHTING, sizeof(LightingBlock), 1);
+
+  GLuint normalMap = Texture_CreateProceduralNormalMap(512, 512);
+  GLuint asphaltNormalMap = Texture_CreateNoiseNormalMap(512, 512);
+  GLuint grassTexture = Texture_CreateGrassTexture(512, 512);
+
+  // Create Cube Mesh for pathways
+  Mesh floorMesh = Mesh_CreateCube(FLOOR_WIDTH, FLOOR_HEIGHT, FLOOR_DEPTH);
+
+  // Create Road Mesh (Asphalt)
+  Mesh roadMesh = Mesh_CreateCube(ROAD_WIDTH, ROAD_HEIGHT, ROAD_DEPTH);
+
+  // Create Grass Mesh
+  Mesh grassMesh = Mesh_CreateCube(GRASS_WIDTH, GRASS_HEIGHT, GRASS_DEPTH);
+
+  // Create Border Mesh (Curb)
+  Mesh borderMesh = Mesh_CreateCube(BORDER_WIDTH, BORDER_HEIGHT, BORDER_DEPTH);
+
+  Mesh skyboxMesh = Mesh_CreateCube(100.0f, 100.0f, 100.0f);
+
   // Create Fence Mesh (Cube)
   Mesh fenceMesh = Mesh_CreateCube(FENCE_WIDTH, FENCE_HEIGHT, FENCE_DEPTH);
 
@@ -310,33 +364,21 @@ int main() {
   // Radius ~0.5, Height ~5.0 (long enough to fade out)
   Mesh godrayMesh = Mesh_CreateCylinder(0.2f, 7.5f, 32);
 
-  // Load Castle Model & Texture
-  Mesh castleMesh;
-  GLuint castleTexture;
-  LoadModelWithTexture("../materials/castle/rcastle.obj",
-                       "../materials/castle/texture_diffuse.png", &castleMesh,
-                       &castleTexture);
+  // Upload everything the workers have prepared
+  AssetLoader_Finish(loader);
 
   // --- Setup Flower Instances ---
   float flowerStartZ = 6.0f;
   float flowerEndZ = 42.5f;
-  int zCount = 0;
-  for (float z = flowerStartZ; z <= flowerEndZ; z += FLOWER_SPACING_Z) {
-    zCount++;
-  }
-  int totalFlowers = FLOWER_ROWS * zCount * 4; // 4 sections (L/R, Near/Far)
-  float *flowerMatrices = (float *)malloc(totalFlowers * 16 * sizeof(float));
-  // Allocate extra space for 4 central flowers
-  float *flowerWMatrices =
-      (float *)malloc((totalFlowers + 4) * 16 * sizeof(float));
-  int fIdx = 0;
-  int fwIdx = 0;
+  StaticBatch flowerBatch, flowerWBatch;
+  StaticBatch_Init(&flowerBatch, &flowerMesh);
+  StaticBatch_Init(&flowerWBatch, &flowerWMesh);
 // Helper macro to add flower to random list
 #define ADD_FLOWER(model)                                                      \
   if (rand() % 2 == 0) {                                                       \
-    storeMatrix(flowerMatrices, fIdx++, model);                                \
+    StaticBatch_Add(&flowerBatch, model, BATCH_ALL_PASSES);                    \
   } else {                                                                     \
-    storeMatrix(flowerWMatrices, fwIdx++, model);                              \
+    StaticBatch_Add(&flowerWBatch, model, BATCH_ALL_PASSES);                   \
   }
 
   // Left Side (Near)
@@ -407,13 +449,11 @@ int main() {
         scale(FLOWER_SCALE * 5, 1.5 * FLOWER_SCALE, 5 * FLOWER_SCALE), model);
     model = mat4_multiply(rotate_y(90.0f), model);
     // model = mat4_multiply(rotate_x(90.0f), model);
-    storeMatrix(flowerWMatrices, fwIdx++, model);
+    StaticBatch_Add(&flowerWBatch, model, BATCH_ALL_PASSES);
   }
 
-  Mesh_SetupInstanced(&flowerMesh, fIdx, flowerMatrices);
-  Mesh_SetupInstanced(&flowerWMesh, fwIdx, flowerWMatrices);
-  free(flowerMatrices);
-  free(flowerWMatrices);
+  StaticBatch_Build(&flowerBatch);
+  StaticBatch_Build(&flowerWBatch);
 
   // 5. Lighting Config
   vec3 sunDir = {SUN_DIR_X, SUN_DIR_Y, SUN_DIR_Z};
@@ -421,33 +461,27 @@ int main() {
   vec3 skyColor = {SKY_COLOR_R, SKY_COLOR_G, SKY_COLOR_B};
   vec3 groundColor = {GROUND_COLOR_R, GROUND_COLOR_G, GROUND_COLOR_B};
 
+  // Grass fades into the fog sooner than stone
   Shader_Use(grassShader);
-  Shader_SetInt(grassShader, "diffuseMap", 1); // Bind to GL_TEXTURE1
-  Shader_SetInt(grassShader, "normalMap", 0);  // Bind to GL_TEXTURE0
-
-  Shader_Use(shader);
-  Shader_SetInt(shader, "normalMap", 0);
-  Shader_SetInt(
-      shader, "diffuseMap",
-      1); // Texture unit 1 for diffuse .. maybe not work in mac (Metal)
-  Shader_SetVec3(shader, "sunDir", sunDir.x, sunDir.y, sunDir.z);
-  Shader_SetVec3(shader, "sunColor", sunColor.x, sunColor.y, sunColor.z);
-  Shader_SetVec3(shader, "skyColor", skyColor.x, skyColor.y, skyColor.z);
-  Shader_SetVec3(shader, "groundColor", groundColor.x, groundColor.y,
-                 groundColor.z);
+  Shader_SetFloat(grassShader, "fogDensity", 0.005f);
+
+  LightingBlock lighting = {{sunDir.x, sunDir.y, sunDir.z},
+                            0.0f,
+                            {sunColor.x, sunColor.y, sunColor.z},
+                            0.0f,
+                            {skyColor.x, skyColor.y, skyColor.z},
+                            0.0f,
+                            {groundColor.x, groundColor.y, groundColor.z},
+                            0.0f};
+  UniformBuffer_Update(&lightingUBO, 0, &lighting);
 
   // --- Setup Hedge Instances ---
   // Hedges at x = -35 and x = 35
   // Similar to flowers, iterate along Z
   float hedgeStartZ = -40.0f; // Start further back
   float hedgeEndZ = 40.0f;    // End further forward
-  int hZCount = 0;
-  for (float z = hedgeStartZ; z <= hedgeEndZ; z += HEDGE_SPACING_Z) {
-    hZCount++;
-  }
-  int totalHedges = hZCount * 2; // Left and Right
-  float *hedgeMatrices = (float *)malloc(totalHedges * 16 * sizeof(float));
-  int hIdx = 0;
+  StaticBatch hedgeBatch;
+  StaticBatch_Init(&hedgeBatch, &hedgeMesh);
 
   // Left Hedges (x = -35)
   for (float z = hedgeStartZ; z <= hedgeEndZ; z += HEDGE_SPACING_Z) {
@@ -459,7 +493,7 @@ int main() {
     model = mat4_multiply(
         scale(0.7 * HEDGE_SCALE, HEDGE_SCALE * 2.0f, HEDGE_SCALE), model);
     model = mat4_multiply(rotate_y(90.0f), model);
-    storeMatrix(hedgeMatrices, hIdx++, model);
+    StaticBatch_Add(&hedgeBatch, model, BATCH_ALL_PASSES);
   }
 
   // Right Hedges (x = 35)
@@ -472,11 +506,193 @@ int main() {
     model = mat4_multiply(
         scale(HEDGE_SCALE * 0.7, HEDGE_SCALE * 2.0f, HEDGE_SCALE), model);
     model = mat4_multiply(rotate_y(90.0f), model);
-    storeMatrix(hedgeMatrices, hIdx++, model);
+    StaticBatch_Add(&hedgeBatch, model, BATCH_ALL_PASSES);
+  }
+
+  StaticBatch_Build(&hedgeBatch);
+
+  // --- Setup God Ray Instances ---
+  // God Ray Positions (Along the pathway, surrounding flowers)
+  // Flowers are at X = +/- 5.0
+  // Z range: Start 6.0, End 42.5, Spacing 7.0
+  // We place rays slightly outside the flowers (e.g., X = +/- 6.5)
+  // and along the same Z intervals.
+
+  float rayStartZ = 2.7f;
+  float rayEndZ = 42.5f;
+  float rayOffsetFromFlower = 0.95f; // Distance from flower center
+  // 8 rays per flower: 2 flanking rays mirrored into the 4 sections
+  StaticBatch rayBatch;
+  StaticBatch_Init(&rayBatch, &godrayMesh);
+
+  for (float z = rayStartZ; z <= rayEndZ; z += FLOWER_SPACING_Z) {
+    for (int row = 0; row < FLOWER_ROWS; row++) {
+      float flowerX = FLOWER_OFFSET_X_START + row * FLOWER_SPACING_X;
+
+      // Two rays per flower (flanking)
+      float rayX1 = flowerX - rayOffsetFromFlower;
+      float rayX2 = flowerX + rayOffsetFromFlower;
+
+      // --- Ray 1 (Inner side of flower) ---
+      // Left Side
+      mat4 modelRayLeft1 = identity();
+      modelRayLeft1 = mat4_multiply(translate(-rayX1, GODRAY_OFFSET_Y, z),
+                                    modelRayLeft1);
+      StaticBatch_Add(&rayBatch, modelRayLeft1, BATCH_ALL_PASSES);
+
+      // Right Side
+      mat4 modelRayRight1 = identity();
+      modelRayRight1 = mat4_multiply(translate(rayX1, GODRAY_OFFSET_Y, z),
+                                     modelRayRight1);
+      StaticBatch_Add(&rayBatch, modelRayRight1, BATCH_ALL_PASSES);
+
+      // Far Side Left
+      mat4 modelRayLeftFar1 = identity();
+      modelRayLeftFar1 = mat4_multiply(
+          translate(-rayX1, GODRAY_OFFSET_Y, -z), modelRayLeftFar1);
+      StaticBatch_Add(&rayBatch, modelRayLeftFar1, BATCH_ALL_PASSES);
+
+      // Far Side Right
+      mat4 modelRayRightFar1 = identity();
+      modelRayRightFar1 = mat4_multiply(
+          translate(rayX1, GODRAY_OFFSET_Y, -z), modelRayRightFar1);
+      StaticBatch_Add(&rayBatch, modelRayRightFar1, BATCH_ALL_PASSES);
+
+      // --- Ray 2 (Outer side of flower) ---
+      // Left Side
+      mat4 modelRayLeft2 = identity();
+      modelRayLeft2 = mat4_multiply(translate(-rayX2, GODRAY_OFFSET_Y, z),
+                                    modelRayLeft2);
+      StaticBatch_Add(&rayBatch, modelRayLeft2, BATCH_ALL_PASSES);
+
+      // Right Side
+      mat4 modelRayRight2 = identity();
+      modelRayRight2 = mat4_multiply(translate(rayX2, GODRAY_OFFSET_Y, z),
+                                     modelRayRight2);
+      StaticBatch_Add(&rayBatch, modelRayRight2, BATCH_ALL_PASSES);
+
+      // Far Side Left
+      mat4 modelRayLeftFar2 = identity();
+      modelRayLeftFar2 = mat4_multiply(
+          translate(-rayX2, GODRAY_OFFSET_Y, -z), modelRayLeftFar2);
+      StaticBatch_Add(&rayBatch, modelRayLeftFar2, BATCH_ALL_PASSES);
+
+      // Far Side Right
+      mat4 modelRayRightFar2 = identity();
+      modelRayRightFar2 = mat4_multiply(
+          translate(rayX2, GODRAY_OFFSET_Y, -z), modelRayRightFar2);
+      StaticBatch_Add(&rayBatch, modelRayRightFar2, BATCH_ALL_PASSES);
+    }
+  }
+
+  StaticBatch_Build(&rayBatch);
+
+  // --- Setup Static Batches ---
+  // Fixed scenery is placed once here; each batch is one instanced draw per
+  // pass. Roads, floors, outer borders and grass are hidden in the
+  // reflection pass (they would block the view of the sky and bridge).
+  float outerBorderOffset = 1.925f;
+
+  // Pathways (Near/Far) and outer floors
+  StaticBatch floorBatch;
+  StaticBatch_Init(&floorBatch, &floorMesh);
+  mat4 pathway = identity();
+  pathway.m[13] = -1.0f; // Y = -1 (Top at 0)
+  pathway.m[14] = SECTION_OFFSET_Z;
+  StaticBatch_Add(&floorBatch, pathway, BATCH_SKIP_REFLECTION);
+  pathway.m[14] = -SECTION_OFFSET_Z;
+  StaticBatch_Add(&floorBatch, pathway, BATCH_SKIP_REFLECTION);
+  StaticBatch_AddSymmetric(&floorBatch, OUTER_FLOOR_OFFSET_X, -1.0f,
+                           SECTION_OFFSET_Z, BATCH_SKIP_REFLECTION);
+  StaticBatch_Build(&floorBatch);
+
+  // Asphalt roads
+  StaticBatch roadBatch;
+  StaticBatch_Init(&roadBatch, &roadMesh);
+  StaticBatch_AddSymmetric(&roadBatch, ROAD_OFFSET_X, -1.0f, SECTION_OFFSET_Z,
+                           BATCH_SKIP_REFLECTION);
+  StaticBatch_Build(&roadBatch);
+
+  // Road borders (curbs), then the borders next to the grass
+  StaticBatch borderBatch;
+  StaticBatch_Init(&borderBatch, &borderMesh);
+  StaticBatch_AddSymmetric(&borderBatch, BORDER_X_INNER, BORDER_Y,
+                           SECTION_OFFSET_Z, BATCH_ALL_PASSES);
+  StaticBatch_AddSymmetric(&borderBatch, BORDER_X_OUTER, BORDER_Y,
+                           SECTION_OFFSET_Z, BATCH_ALL_PASSES);
+  StaticBatch_AddSymmetric(&borderBatch,
+                           OUTER_FLOOR_OFFSET_X - outerBorderOffset, BORDER_Y,
+                           SECTION_OFFSET_Z, BATCH_SKIP_REFLECTION);
+  StaticBatch_AddSymmetric(&borderBatch,
+                           OUTER_FLOOR_OFFSET_X + outerBorderOffset, BORDER_Y,
+                           SECTION_OFFSET_Z, BATCH_SKIP_REFLECTION);
+  StaticBatch_Build(&borderBatch);
+
+  // Inner and outer grass fields
+  StaticBatch grassBatch;
+  StaticBatch_Init(&grassBatch, &grassMesh);
+  StaticBatch_AddSymmetric(&grassBatch, GRASS_OFFSET_X, -1.0f,
+                           SECTION_OFFSET_Z, BATCH_SKIP_REFLECTION);
+  StaticBatch_AddSymmetric(&grassBatch, OUTER_GRASS_OFFSET_X, -1.0f,
+                           SECTION_OFFSET_Z, BATCH_SKIP_REFLECTION);
+  StaticBatch_Build(&grassBatch);
+
+  // Gazebos at the 4 corners of each grass field
+  // Grass Field Dimensions: 30.0f x 40.0f
+  // Half dimensions: 15.0f, 20.0f
+  // We want corners, so let's use offsets close to these values.
+  StaticBatch gazeboBatch;
+  StaticBatch_Init(&gazeboBatch, &gazeboMesh);
+  float gOffsetX = 5.0f;
+  float gOffsetZ = 15.0f;
+
+  // Relative positions for 4 corners of a field
+  float gCornersX[] = {gOffsetX, gOffsetX, -gOffsetX, -gOffsetX};
+  float gCornersZ[] = {gOffsetZ, -gOffsetZ, gOffsetZ, -gOffsetZ};
+
+  // Centers of the 4 grass fields
+  float fieldCentersX[] = {-GRASS_OFFSET_X, GRASS_OFFSET_X, -GRASS_OFFSET_X,
+                           GRASS_OFFSET_X};
+  float fieldCentersZ[] = {SECTION_OFFSET_Z, SECTION_OFFSET_Z,
+                           -SECTION_OFFSET_Z, -SECTION_OFFSET_Z};
+
+  // Pre-calculate Gazebo Scale and Rotation
+  mat4 gazeboSR = identity();
+  gazeboSR =
+      mat4_multiply(scale(GAZEBO_SCALE, GAZEBO_SCALE, GAZEBO_SCALE), gazeboSR);
+  // gazeboSR = mat4_multiply(rotate_x(90.0f), gazeboSR);
+
+  for (int f = 0; f < 4; f++) {   // For each field
+    for (int i = 0; i < 4; i++) { // For each corner
+      // Translate: Field Center + Corner Offset
+      mat4 modelGazebo = mat4_multiply(
+          gazeboSR, translate(fieldCentersX[f] + gCornersX[i], GAZEBO_Y_OFFSET,
+                              fieldCentersZ[f] + gCornersZ[i]));
+      StaticBatch_Add(&gazeboBatch, modelGazebo, BATCH_ALL_PASSES);
+    }
   }
+  StaticBatch_Build(&gazeboBatch);
+
+  // Fences between hedges
+  // Hedge Z loop was: z = hedgeStartZ to hedgeEndZ step HEDGE_SPACING_Z
+  // We want to place a fence at z + HEDGE_SPACING_Z / 2.0f
+  // But stop before the last hedge
+  StaticBatch fenceBatch;
+  StaticBatch_Init(&fenceBatch, &fenceMesh);
+  for (float z = hedgeStartZ; z < hedgeEndZ; z += HEDGE_SPACING_Z) {
+    if (fabs(z) < 8.0f)
+      continue; // Skip bridge area
+
+    float midZ = z + HEDGE_SPACING_Z / 2.0f;
 
-  Mesh_SetupInstanced(&hedgeMesh, hIdx, hedgeMatrices);
-  free(hedgeMatrices);
+    // Also check if midZ is in bridge area
+    if (fabs(midZ) < 8.0f)
+      continue;
+
+    StaticBatch_AddSymmetric(&fenceBatch, HEDGE_OFFSET_X, FENCE_Y_OFFSET, midZ,
+                             BATCH_ALL_PASSES);
+  }
+  StaticBatch_Build(&fenceBatch);
 
   // Water Setup
   int width, height;
@@ -484,42 +700,119 @@ int main() {
   WaterFrameBuffers waterFBOs = WaterFBO_Init(width, height);
   GLuint waterShader =
       Shader_Create("shaders/water.vert", "shaders/water.frag");
-  GLuint waterDUDV = Texture_Load("../materials/water/dudv.png");
+  UniformBuffer_BindBlocks(waterShader);
   // Use existing normalMap for water normal map for now
   Mesh waterMesh = Mesh_CreatePlane(100.0f);
   float waterMoveFactor = 0.0f;
 
+  // Opaque surface materials:
+  // {program, normal map, diffuse map, color, shininess, specular intensity,
+  //  profiler stage}
+  // Pathways and outer floors: Stone Grey
+  Material floorMaterial = {stoneShader, normalMap, 0,
+                            {0.4f, 0.4f, 0.45f}, 32.0f, 0.2f, "floor"};
+  // Asphalt roads: darker, rougher surface with the noise normal map
+  Material roadMaterial = {stoneShader, asphaltNormalMap, 0,
+                           {0.2f, 0.2f, 0.22f}, 10.0f, 0.1f, "floor"};
+  // Road and outer borders (curbs): light stone
+  Material borderMaterial = {stoneShader, normalMap, 0,
+                             {0.7f, 0.7f, 0.7f}, 32.0f, 0.5f, "floor"};
+  // Diffuse map only: the bridge has no normal map loaded yet, and using
+  // road's would be wrong. White objectColor shows the texture as is.
+  Material bridgeMaterial = {texturedShader, 0, bridgeTexture,
+                             {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "bridge"};
+  Material halfpipeMaterial = {texturedShader, 0, halfpipeTexture,
+                               {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "bridge"};
+  Material castleMaterial = {texturedShader, 0, castleTexture,
+                             {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "castle"};
+  // Grass: noise normal map for unevenness, matte
+  Material grassMaterial = {grassShader, asphaltNormalMap, grassTexture,
+                            {1.0f, 1.0f, 1.0f}, 5.0f, 0.05f, "grass"};
+  Material gazeboMaterial = {foliageShader, 0, gazeboTexture,
+                             {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "foliage"};
+  Material flowerMaterial = {foliageShader, 0, flowerTexture,
+                             {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "foliage"};
+  Material flowerWMaterial = {foliageShader, 0, flowerWTexture,
+                              {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "foliage"};
+  Material hedgeMaterial = {foliageShader, 0, hedgeTexture,
+                            {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f, "foliage"};
+  // Far hedges and flowers: their own captures, lit with the same values
+  Impostor hedgeImpostor, flowerImpostor, flowerWImpostor;
+  Impostor_Init(&hedgeImpostor, &hedgeBatch, HEDGE_IMPOSTOR_DISTANCE,
+                foliageCaptureShader, 0, hedgeTexture);
+  Impostor_Init(&flowerImpostor, &flowerBatch, FLOWER_IMPOSTOR_DISTANCE,
+                foliageCaptureShader, 0, flowerTexture);
+  Impostor_Init(&flowerWImpostor, &flowerWBatch, FLOWER_IMPOSTOR_DISTANCE,
+                foliageCaptureShader, 0, flowerWTexture);
+  Material hedgeImpostorMaterial = {impostorShader, hedgeImpostor.normals,
+                                    hedgeImpostor.albedo,
+                                    {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f,
+                                    "foliage"};
+  Material flowerImpostorMaterial = {impostorShader, flowerImpostor.normals,
+                                     flowerImpostor.albedo,
+                                     {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f,
+                                     "foliage"};
+  Material flowerWImpostorMaterial = {impostorShader, flowerWImpostor.normals,
+                                      flowerWImpostor.albedo,
+                                      {1.0f, 1.0f, 1.0f}, 10.0f, 0.1f,
+                                      "foliage"};
+  // Simple material for Stone, no texture maps for now (Stone Grey)
+  Material fenceMaterial = {plainShader, 0, 0,
+                            {0.5f, 0.5f, 0.55f}, 32.0f, 0.2f, "foliage"};
+  RenderQueue renderQueue;
+  RenderQueue_Init(&renderQueue);
+  Occlusion occlusion;
+  Occlusion_Init(&occlusion, occluderShader);
+
+  if (bench.enabled)
+    Bench_Init(&bench, width, height);
+  Profiler_Init();
+  const char *passNames[3] = {"reflection", "refraction", "main"};
+
   // 6. Main Loop
   float deltaTime = 0.0f;
   float lastFrame = 0.0f;
 
   // while the window is open
   while (!glfwWindowShouldClose(window)) {
-    // Time
+    if (bench.enabled) {
+      if (Bench_Done(&bench))
+        break;
+      Bench_BeginFrame(&bench);
+    }
+    RenderStats_Reset();
+    GLStateStats frameStateStats = GLState_GetStats();
+    Profiler_BeginFrame();
+    // Time (fixed step when benchmarking so every run animates identically)
     float currentFrame = (float)glfwGetTime();
-    deltaTime = currentFrame - lastFrame;
+    deltaTime = bench.enabled ? 1.0f / 60.0f : currentFrame - lastFrame;
     lastFrame = currentFrame;
 
-    // Input
-    if (Input_GetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-      glfwSetWindowShouldClose(window, 1);
-
-    float dx, dy;
-    Input_GetMouseDelta(&dx, &dy);
-    Camera_ProcessMouseMovement(&camera, dx, dy);
-
     // Store current position before movement for collision logic
     vec3 prevPos = camera.Position;
 
-    // WASD movement (horizontal only)
-    if (Input_GetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-      Camera_ProcessKeyboard(&camera, CAM_FORWARD, deltaTime);
-    if (Input_GetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-      Camera_ProcessKeyboard(&camera, CAM_BACKWARD, deltaTime);
-    if (Input_GetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-      Camera_ProcessKeyboard(&camera, CAM_LEFT, deltaTime);
-    if (Input_GetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-      Camera_ProcessKeyboard(&camera, CAM_RIGHT, deltaTime);
+    if (bench.enabled) {
+      Bench_UpdateCamera(&bench, &camera);
+    } else {
+      // Input
+      if (Input_GetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, 1);
+      Overlay_HandleInput(window);
+
+      float dx, dy;
+      Input_GetMouseDelta(&dx, &dy);
+      Camera_ProcessMouseMovement(&camera, dx, dy);
+
+      // WASD movement (horizontal only)
+      if (Input_GetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        Camera_ProcessKeyboard(&camera, CAM_FORWARD, deltaTime);
+      if (Input_GetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        Camera_ProcessKeyboard(&camera, CAM_BACKWARD, deltaTime);
+      if (Input_GetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        Camera_ProcessKeyboard(&camera, CAM_LEFT, deltaTime);
+      if (Input_GetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        Camera_ProcessKeyboard(&camera, CAM_RIGHT, deltaTime);
+    }
 
     // --- Apply World Boundaries (Collision) ---
 
@@ -575,6 +868,7 @@ int main() {
     float savedCameraPitch = camera.Pitch;
 
     for (int pass = 0; pass < 3; pass++) {
+      Profiler_Begin(passNames[pass]);
       if (pass == 0) {
         WaterFBO_BindReflectionFrameBuffer(&waterFBOs, width, height);
         float distance = 2 * (camera.Position.y - WATER_HEIGHT);
@@ -587,22 +881,22 @@ int main() {
         if (camera.Pitch < -80.0f)
           camera.Pitch = -80.0f;
         Camera_UpdateVectors(&camera);
-        glDisable(GL_CULL_FACE);
+        GLState_Disable(GL_CULL_FACE);
       } else if (pass == 1) {
         WaterFBO_BindRefractionFrameBuffer(&waterFBOs, width, height);
+      } else if (bench.enabled) {
+        Bench_BindTarget(&bench);
       } else {
         WaterFBO_UnbindCurrentFrameBuffer(width, height);
       }
 
       int drawWidth = (pass == 0) ? 1280 : (pass == 1) ? 1280 : width;
       int drawHeight = (pass == 0) ? 720 : (pass == 1) ? 720 : height;
-      glViewport(0, 0, drawWidth, drawHeight);
+      GLState_Viewport(0, 0, drawWidth, drawHeight);
 
       glClearColor(0.7f, 0.25f, 0.15f, 1.0f);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-      Shader_Use(shader);
-
       vec4 plane;
       if (pass == 0)
         plane = (vec4){0.0f, 1.0f, 0.0f, -WATER_HEIGHT + 0.0f};
@@ -610,131 +904,31 @@ int main() {
         plane = (vec4){0.0f, -1.0f, 0.0f, WATER_HEIGHT};
       else
         plane = (vec4){0.0f, 1.0f, 0.0f, 10000.0f};
-      Shader_SetVec4(shader, "plane", plane.x, plane.y, plane.z, plane.w);
-
-      Shader_Use(grassShader);
-      Shader_SetVec4(grassShader, "plane", plane.x, plane.y, plane.z, plane.w);
-
-      Shader_Use(instancedShader);
-      Shader_SetVec4(instancedShader, "plane", plane.x, plane.y, plane.z,
-                     plane.w);
-
-      Shader_Use(godrayShader);
-      Shader_SetVec4(godrayShader, "plane", plane.x, plane.y, plane.z, plane.w);
-
-      Shader_Use(shader);
 
       mat4 view = Camera_GetViewMatrix(&camera);
       mat4 proj = perspective(1.57f, (float)drawWidth / (float)drawHeight, 0.1f,
                               2000.0f);
 
-      Shader_SetMat4(shader, "view", view.m);
-      Shader_SetMat4(shader, "projection", proj.m);
-      Shader_SetVec3(shader, "viewPos", camera.Position.x, camera.Position.y,
-                     camera.Position.z);
-
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, normalMap);
-      Shader_SetInt(shader, "useNormalMap",
-                    1); // Enable normal map for floor/road
-
-      // Draw Pathway 1 (Near) - Z = 22.5
-      // NOTE: We disable floor rendering in the reflection pass (pass == 0).
-      // Since the reflection camera is inverted (underwater looking up),
-      // the floor geometry would block the view of the sky and bridge.
-      if (pass != 0) {
-        mat4 model1 = identity();
-        model1.m[13] = -1.0f; // Y = -1 (Top at 0)
-        model1.m[14] = SECTION_OFFSET_Z;
-        Shader_SetMat4(shader, "model", model1.m);
-        Shader_SetVec3(shader, "objectColor", 0.4f, 0.4f, 0.45f); // Stone Grey
-        Shader_SetFloat(shader, "shininess", 32.0f);
-        Shader_SetFloat(shader, "specularIntensity", 0.2f);
-        Shader_SetInt(shader, "useDiffuseMap", 0); // No diffuse map
-        Mesh_Draw(&floorMesh);
-
-        // Draw Pathway 2 (Far) - Z = -22.5
-        mat4 model2 = identity();
-        model2.m[13] = -1.0f; // Y = -1
-        model2.m[14] = -SECTION_OFFSET_Z;
-        Shader_SetMat4(shader, "model", model2.m);
-        Shader_SetVec3(shader, "objectColor", 0.4f, 0.4f, 0.45f); // Stone Grey
-        // Shininess and Specular Intensity already set for floor
-        Mesh_Draw(&floorMesh);
-      }
-
-      // --- Draw Asphalt Roads ---
-      // NOTE: Disable roads in reflection pass to prevent obstruction.
-      if (pass != 0) {
-        // Darker color for asphalt
-        Shader_SetVec3(shader, "objectColor", 0.2f, 0.2f, 0.22f);
-        // Rougher surface for asphalt
-        Shader_SetFloat(shader, "shininess", 10.0f);
-        Shader_SetFloat(shader, "specularIntensity", 0.1f);
-
-        // Bind Asphalt Normal Map
-        glBindTexture(GL_TEXTURE_2D, asphaltNormalMap);
-
-        DrawSymmetricLayer(shader, &roadMesh, ROAD_OFFSET_X, -1.0f,
-                           SECTION_OFFSET_Z);
-      }
-
-      // --- Draw Road Borders (Curbs) ---
-      // Material: Stone Grey
-      Shader_SetVec3(shader, "objectColor", 0.7f, 0.7f, 0.7f);
-      Shader_SetFloat(shader, "shininess", 32.0f);
-      Shader_SetFloat(shader, "specularIntensity", 0.5f);
-      Shader_SetInt(shader, "useDiffuseMap", 0); // Ensure no texture
-
-      // Bind default normal map (flat)
-      glBindTexture(GL_TEXTURE_2D, normalMap);
-
-      // Draw Inner and Outer Borders symmetrically
-      DrawSymmetricLayer(shader, &borderMesh, BORDER_X_INNER, BORDER_Y,
-                         SECTION_OFFSET_Z);
-      DrawSymmetricLayer(shader, &borderMesh, BORDER_X_OUTER, BORDER_Y,
-                         SECTION_OFFSET_Z);
-
-      // --- Draw Outer Floor & Borders (Next to Grass) ---
-      // --- Draw Outer Floor & Borders (Next to Grass) ---
-      if (pass != 0) {
-        // Use Floor Material
-        Shader_SetVec3(shader, "objectColor", 0.4f, 0.4f, 0.45f); // Stone Grey
-        Shader_SetFloat(shader, "shininess", 32.0f);
-        Shader_SetFloat(shader, "specularIntensity", 0.2f);
-        Shader_SetInt(shader, "useDiffuseMap", 0);
-        Shader_SetInt(shader, "useNormalMap", 1);
-        glBindTexture(GL_TEXTURE_2D, normalMap);
-
-        // Draw Outer Floor
-        DrawSymmetricLayer(shader, &floorMesh, OUTER_FLOOR_OFFSET_X, -1.0f,
-                           SECTION_OFFSET_Z);
-
-        // Use Border Material
-        Shader_SetVec3(shader, "objectColor", 0.7f, 0.7f, 0.7f);
-        Shader_SetFloat(shader, "shininess", 32.0f);
-        Shader_SetFloat(shader, "specularIntensity", 0.5f);
-
-        // Draw Outer Borders
-        float outerBorderOffset = 1.925f;
-        DrawSymmetricLayer(shader, &borderMesh,
-                           OUTER_FLOOR_OFFSET_X - outerBorderOffset, BORDER_Y,
-                           SECTION_OFFSET_Z);
-        DrawSymmetricLayer(shader, &borderMesh,
-                           OUTER_FLOOR_OFFSET_X + outerBorderOffset, BORDER_Y,
-                           SECTION_OFFSET_Z);
-      }
-
-      // --- Draw Bridge ---
-      // Use diffuse map
-      Shader_SetInt(shader, "useDiffuseMap", 1);
-      // Disable normal map for bridge (it doesn't have one loaded yet, and
-      // using road's would be wrong)
-      Shader_SetInt(shader, "useNormalMap", 0);
-
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, bridgeTexture);
-
+      // One upload per pass feeds view/projection/viewPos/plane to every
+      // program through the Camera block
+      CameraBlock cameraBlock;
+      memcpy(cameraBlock.view, view.m, sizeof(cameraBlock.view));
+      memcpy(cameraBlock.projection, proj.m, sizeof(cameraBlock.projection));
+      cameraBlock.viewPos[0] = camera.Position.x;
+      cameraBlock.viewPos[1] = camera.Position.y;
+      cameraBlock.viewPos[2] = camera.Position.z;
+      cameraBlock.pad0 = 0.0f;
+      cameraBlock.plane[0] = plane.x;
+      cameraBlock.plane[1] = plane.y;
+      cameraBlock.plane[2] = plane.z;
+      cameraBlock.plane[3] = plane.w;
+      UniformBuffer_Update(&cameraUBO, pass, &cameraBlock);
+
+      int reflectionPass = (pass == 0);
+      mat4 viewProj = mat4_multiply(view, proj);
+      Frustum frustum = Frustum_FromMatrix(viewProj);
+
+      // --- Placements of the big single meshes (also the occluders) ---
       mat4 modelBridge = identity();
       modelBridge = mat4_multiply(
           scale(0.72 * BRIDGE_SCALE, 1.1 * BRIDGE_SCALE, 0.8 * BRIDGE_SCALE),
@@ -745,124 +939,21 @@ int main() {
       modelBridge = mat4_multiply(
           translate(BRIDGE_OFFSET_X, BRIDGE_Y_OFFSET, BRIDGE_OFFSET_Z),
           modelBridge);
-      Shader_SetMat4(shader, "model", modelBridge.m);
-
-      // Material properties for bridge
-      Shader_SetVec3(shader, "objectColor", 1.0f, 1.0f,
-                     1.0f); // White to show texture
-      Shader_SetFloat(shader, "shininess",
-                      10.0f); // Lower shininess for matte look
-      Shader_SetFloat(shader, "specularIntensity",
-                      0.1f); // Lower specular intensity
-
-      Mesh_Draw(&bridgeMesh);
-
-      // --- Draw Halfpipe ---
-      // NOTE: Disable halfpipe (canal) in reflection pass to prevent
-      // obstruction.
-      if (pass != 0) {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, halfpipeTexture);
-
-        mat4 modelHalfpipe = identity();
-        // Scale
-        modelHalfpipe = mat4_multiply(
-            scale(2 * HALFPIPE_SCALE, 1 * HALFPIPE_SCALE, 1 * HALFPIPE_SCALE),
-            modelHalfpipe);
-        // Rotate
-        modelHalfpipe = mat4_multiply(rotate_y(90.0f), modelHalfpipe);
-        modelHalfpipe = mat4_multiply(rotate_x(90.0f), modelHalfpipe);
-
-        //  Position under bridge (lower Y)
-
-        modelHalfpipe = mat4_multiply(
-            translate(HALFPIPE_OFFSET_X, HALFPIPE_OFFSET_Y, HALFPIPE_OFFSET_Z),
-            modelHalfpipe);
-
-        Shader_SetMat4(shader, "model", modelHalfpipe.m);
-        Mesh_Draw(&halfpipeMesh);
-      }
-
-      // --- Draw Grass Fields ---
-      // NOTE: Disable grass fields in reflection pass to prevent obstruction.
-      if (pass != 0) {
-        Shader_Use(grassShader);
-
-        // Set View/Projection
-        Shader_SetMat4(grassShader, "view", view.m);
-        Shader_SetMat4(grassShader, "projection", proj.m);
-        Shader_SetVec3(grassShader, "viewPos", camera.Position.x,
-                       camera.Position.y, camera.Position.z);
-
-        // Set Lighting Uniforms
-        Shader_SetVec3(grassShader, "sunDir", SUN_DIR_X, SUN_DIR_Y, SUN_DIR_Z);
-        Shader_SetVec3(grassShader, "sunColor", SUN_COLOR_R, SUN_COLOR_G,
-                       SUN_COLOR_B);
-        Shader_SetVec3(grassShader, "skyColor", skyColor.x, skyColor.y,
-                       skyColor.z);
-        Shader_SetVec3(grassShader, "groundColor", groundColor.x, groundColor.y,
-                       groundColor.z);
-
-        // Material Properties
-        Shader_SetVec3(grassShader, "objectColor", 1.0f, 1.0f, 1.0f);
-        Shader_SetInt(grassShader, "useDiffuseMap", 1);
-        Shader_SetInt(grassShader, "useNormalMap",
-                      1); // Enable normal map for unevenness
-        Shader_SetFloat(grassShader, "shininess", 5.0f);
-        Shader_SetFloat(grassShader, "specularIntensity", 0.05f);
-
-        // Bind Textures
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D,
-                      asphaltNormalMap); // Use noise normal map for unevenness
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, grassTexture);
-
-        // Draw Inner Grass
-        DrawSymmetricLayer(grassShader, &grassMesh, GRASS_OFFSET_X, -1.0f,
-                           SECTION_OFFSET_Z);
-
-        // Draw Outer Grass
-        DrawSymmetricLayer(grassShader, &grassMesh, OUTER_GRASS_OFFSET_X, -1.0f,
-                           SECTION_OFFSET_Z);
-      }
-
-      // Restore Shader for next objects (if any rely on it being active, though
-      // usually they switch) But next is Skybox which switches shader. However,
-      // we should reset active texture to 0
-      glActiveTexture(GL_TEXTURE0);
-
-      // --- Draw Skybox ---
-      glDepthFunc(GL_LEQUAL);
-      glDisable(GL_CULL_FACE); // Disable culling to see inside the cube
-      Shader_Use(skyboxShader);
-      // Remove translation from view matrix
-      mat4 viewSkybox = view;
-      viewSkybox.m[12] = 0.0f;
-      viewSkybox.m[13] = 0.0f;
-      viewSkybox.m[14] = 0.0f;
-      Shader_SetMat4(skyboxShader, "view", viewSkybox.m);
-      Shader_SetMat4(skyboxShader, "projection", proj.m);
-
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, skyboxTexture);
-      Shader_SetInt(skyboxShader, "skybox", 0);
 
-      Mesh_Draw(&skyboxMesh);
-      glEnable(GL_CULL_FACE); // Re-enable culling
-      glDepthFunc(GL_LESS);
+      mat4 modelHalfpipe = identity();
+      // Scale
+      modelHalfpipe = mat4_multiply(
+          scale(2 * HALFPIPE_SCALE, 1 * HALFPIPE_SCALE, 1 * HALFPIPE_SCALE),
+          modelHalfpipe);
+      // Rotate
+      modelHalfpipe = mat4_multiply(rotate_y(90.0f), modelHalfpipe);
+      modelHalfpipe = mat4_multiply(rotate_x(90.0f), modelHalfpipe);
 
-      // --- Draw Castle ---
-      Shader_Use(shader);
-      Shader_SetInt(shader, "useDiffuseMap", 1);
-      Shader_SetInt(shader, "useNormalMap", 0);
-      Shader_SetVec3(shader, "objectColor", 1.0f, 1.0f, 1.0f);
-      Shader_SetFloat(shader, "shininess", 10.0f);
-      Shader_SetFloat(shader, "specularIntensity", 0.1f);
+      //  Position under bridge (lower Y)
 
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, castleTexture);
+      modelHalfpipe = mat4_multiply(
+          translate(HALFPIPE_OFFSET_X, HALFPIPE_OFFSET_Y, HALFPIPE_OFFSET_Z),
+          modelHalfpipe);
 
       mat4 modelCastle = identity();
 #define CASTLE_SCALE 150.0f
@@ -874,291 +965,177 @@ int main() {
           translate(CASTLE_OFFSET_X, CASTLE_OFFSET_Y, CASTLE_OFFSET_Z),
           modelCastle);
       // modelCastle = mat4_multiply(rotate_x(90.0f), modelCastle);
-      Shader_SetMat4(shader, "model", modelCastle.m);
-      Mesh_Draw(&castleMesh);
-
-      // --- Draw Gazebos ---
-      Shader_Use(shader);
-      // Use diffuse map
-      Shader_SetInt(shader, "useDiffuseMap", 1);
-      Shader_SetVec3(shader, "objectColor", 1.0f, 1.0f,
-                     1.0f); // White to show texture
-      Shader_SetFloat(shader, "shininess", 10.0f);
-      Shader_SetFloat(shader, "specularIntensity", 0.1f);
-
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, gazeboTexture);
-
-      // Bind default normal map (flat)
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, normalMap);
-
-      // Gazebo positions relative to grass fields
-      // Grass Field Dimensions: 30.0f x 40.0f
-      // Half dimensions: 15.0f, 20.0f
-      // We want corners, so let's use offsets close to these values.
-      float gOffsetX = 5.0f;
-      float gOffsetZ = 15.0f;
-
-      // Relative positions for 4 corners of a field
-      float gCornersX[] = {gOffsetX, gOffsetX, -gOffsetX, -gOffsetX};
-      float gCornersZ[] = {gOffsetZ, -gOffsetZ, gOffsetZ, -gOffsetZ};
-
-      // Centers of the 4 grass fields
-      float fieldCentersX[] = {-GRASS_OFFSET_X, GRASS_OFFSET_X, -GRASS_OFFSET_X,
-                               GRASS_OFFSET_X};
-      float fieldCentersZ[] = {SECTION_OFFSET_Z, SECTION_OFFSET_Z,
-                               -SECTION_OFFSET_Z, -SECTION_OFFSET_Z};
-
-      // Pre-calculate Gazebo Scale and Rotation
-      mat4 gazeboSR = identity();
-      gazeboSR = mat4_multiply(scale(GAZEBO_SCALE, GAZEBO_SCALE, GAZEBO_SCALE),
-                               gazeboSR);
-      // gazeboSR = mat4_multiply(rotate_x(90.0f), gazeboSR);
-
-      for (int f = 0; f < 4; f++) {   // For each field
-        for (int i = 0; i < 4; i++) { // For each corner
-          mat4 modelGazebo = identity();
-          // Translate: Field Center + Corner Offset
-          modelGazebo = mat4_multiply(
-              gazeboSR,
-              translate(fieldCentersX[f] + gCornersX[i], GAZEBO_Y_OFFSET,
-                        fieldCentersZ[f] + gCornersZ[i]));
-
-          Shader_SetMat4(shader, "model", modelGazebo.m);
-          Mesh_Draw(&gazeboMesh);
-        }
-      }
 
-      // --- Draw Flowers (Instanced) ---
-      Shader_Use(instancedShader);
-      Shader_SetMat4(instancedShader, "view", view.m);
-      Shader_SetMat4(instancedShader, "projection", proj.m);
-
-      Shader_SetInt(instancedShader, "diffuseMap", 1); // Texture unit 1
-      Shader_SetVec3(instancedShader, "sunDir", sunDir.x, sunDir.y, sunDir.z);
-      Shader_SetVec3(instancedShader, "sunColor", sunColor.x, sunColor.y,
-                     sunColor.z);
-      Shader_SetVec3(instancedShader, "skyColor", skyColor.x, skyColor.y,
-                     skyColor.z);
-      Shader_SetVec3(instancedShader, "groundColor", groundColor.x,
-                     groundColor.y, groundColor.z);
-      Shader_SetVec3(instancedShader, "viewPos", camera.Position.x,
-                     camera.Position.y, camera.Position.z);
-
-      Shader_SetInt(instancedShader, "useDiffuseMap", 1);
-      Shader_SetInt(instancedShader, "useNormalMap", 0);
-      Shader_SetFloat(instancedShader, "shininess", 10.0f);
-      Shader_SetFloat(instancedShader, "specularIntensity", 0.1f);
-
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, flowerTexture);
-      Mesh_DrawInstanced(&flowerMesh, fIdx);
-
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, flowerWTexture);
-      Mesh_DrawInstanced(&flowerWMesh, fwIdx);
-
-      // --- Draw Hedges (Instanced) ---
-      Shader_Use(instancedShader);
-      Shader_SetInt(instancedShader, "useDiffuseMap", 1);
-      Shader_SetInt(instancedShader, "useNormalMap", 0);
-      Shader_SetFloat(instancedShader, "shininess", 10.0f);
-      Shader_SetFloat(instancedShader, "specularIntensity", 0.1f);
-
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, hedgeTexture);
-
-      Mesh_DrawInstanced(&hedgeMesh, hIdx);
-
-      // --- Draw Fences (Between Hedges) ---
-      Shader_Use(
-          shader); // Use standard shader for fences (no instancing needed for
-                   // simple cubes yet, or could instance if many)
-      // Simple material for Stone
-      Shader_SetVec3(shader, "objectColor", 0.5f, 0.5f, 0.55f); // Stone Grey
-      Shader_SetFloat(shader, "shininess", 32.0f);
-      Shader_SetFloat(shader, "specularIntensity", 0.2f);
-      Shader_SetInt(shader, "useDiffuseMap", 0);
-      Shader_SetInt(shader, "useNormalMap", 0); // No normal map for now
-
-      // Iterate through hedge positions to place fences in between
-      // Hedge Z loop was: z = hedgeStartZ to hedgeEndZ step HEDGE_SPACING_Z
-      // We want to place a fence at z + HEDGE_SPACING_Z / 2.0f
-      // But stop before the last hedge
-      for (float z = hedgeStartZ; z < hedgeEndZ; z += HEDGE_SPACING_Z) {
-        if (fabs(z) < 8.0f)
-          continue; // Skip bridge area
-
-        float midZ = z + HEDGE_SPACING_Z / 2.0f;
-
-        // Also check if midZ is in bridge area
-        if (fabs(midZ) < 8.0f)
-          continue;
-
-        DrawSymmetricLayer(shader, &fenceMesh, HEDGE_OFFSET_X, FENCE_Y_OFFSET,
-                           midZ);
+      // --- Hi-Z occlusion ---
+      // The big meshes' depth at low resolution; everything culled in this
+      // pass is also tested against it
+      Profiler_Begin("occlusion");
+      Occlusion_Begin(&occlusion, viewProj);
+      Occlusion_AddOccluder(&occlusion, &castleMesh, modelCastle);
+      Occlusion_AddOccluder(&occlusion, &bridgeMesh, modelBridge);
+      if (pass != 0) // the halfpipe is not drawn in the reflection
+        Occlusion_AddOccluder(&occlusion, &halfpipeMesh, modelHalfpipe);
+      Occlusion_End(&occlusion);
+      Profiler_End();
+
+      // --- Opaque scenery ---
+      // Submitted in any order; the queue sorts by program, textures and
+      // mesh, then front to back
+      Profiler_Begin("opaque");
+      LodView lodView = LodView_Make(camera.Position, proj, drawHeight);
+      RenderQueue_Begin(&renderQueue, &frustum, &occlusion, reflectionPass,
+                        &lodView);
+
+      // Pathways and outer floors, asphalt roads and curbs (hidden in the
+      // reflection pass)
+      RenderQueue_SubmitBatch(&renderQueue, &floorMaterial, &floorBatch);
+      RenderQueue_SubmitBatch(&renderQueue, &roadMaterial, &roadBatch);
+      RenderQueue_SubmitBatch(&renderQueue, &borderMaterial, &borderBatch);
+
+      // --- Bridge ---
+      RenderQueue_SubmitMesh(&renderQueue, &bridgeMaterial, &bridgeMesh,
+                             modelBridge);
+
+      // --- Halfpipe and grass fields ---
+      // NOTE: Disabled in the reflection pass to prevent obstruction.
+      if (pass != 0) {
+        RenderQueue_SubmitMesh(&renderQueue, &halfpipeMaterial, &halfpipeMesh,
+                               modelHalfpipe);
+
+        RenderQueue_SubmitBatch(&renderQueue, &grassMaterial, &grassBatch);
       }
 
-      // Reset Active Texture to 0
-      glActiveTexture(GL_TEXTURE0);
+      // --- Castle ---
+      RenderQueue_SubmitMesh(&renderQueue, &castleMaterial, &castleMesh,
+                             modelCastle);
+
+      // --- Gazebos, flowers, hedges and fences (between hedges) ---
+      RenderQueue_SubmitBatch(&renderQueue, &gazeboMaterial, &gazeboBatch);
+      RenderQueue_SubmitBatch(&renderQueue, &flowerMaterial, &flowerBatch);
+      RenderQueue_SubmitBatch(&renderQueue, &flowerWMaterial, &flowerWBatch);
+      RenderQueue_SubmitBatch(&renderQueue, &hedgeMaterial, &hedgeBatch);
+      RenderQueue_SubmitImpostors(&renderQueue, &hedgeImpostorMaterial,
+                                  &hedgeImpostor);
+      RenderQueue_SubmitImpostors(&renderQueue, &flowerImpostorMaterial,
+                                  &flowerImpostor);
+      RenderQueue_SubmitImpostors(&renderQueue, &flowerWImpostorMaterial,
+                                  &flowerWImpostor);
+      RenderQueue_SubmitBatch(&renderQueue, &fenceMaterial, &fenceBatch);
+
+      RenderQueue_Flush(&renderQueue);
+      Profiler_End();
+
+      // --- Draw Skybox ---
+      // After the opaque geometry so covered sky pixels fail the depth test
+      Profiler_Begin("skybox");
+      GLState_DepthFunc(GL_LEQUAL);
+      GLState_Disable(GL_CULL_FACE); // Disable culling to see inside the cube
+      Shader_Use(skyboxShader);
+      // skybox.vert removes the translation from the Camera block's view
+
+      GLState_BindTexture(0, skyboxTexture);
+      Shader_SetInt(skyboxShader, "skybox", 0);
 
+      Mesh_Draw(&skyboxMesh);
+      GLState_Enable(GL_CULL_FACE); // Re-enable culling
+      GLState_DepthFunc(GL_LESS);
+      Profiler_End();
       // --- Draw God Rays ---
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
-      glDepthMask(GL_FALSE);             // Don't write to depth buffer
+      Profiler_Begin("godrays");
+      GLState_Enable(GL_BLEND);
+      GLState_BlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+      GLState_DepthMask(GL_FALSE); // Don't write to depth buffer
 
       Shader_Use(godrayShader);
-      Shader_SetMat4(godrayShader, "view", view.m);
-      Shader_SetMat4(godrayShader, "projection", proj.m);
       Shader_SetFloat(godrayShader, "height", 10.0f);
       Shader_SetVec3(godrayShader, "color", 1.0f, 0.9f,
                      0.6f); // Warm light color
 
-      // God Ray Positions (Along the pathway, surrounding flowers)
-      // Flowers are at X = +/- 5.0
-      // Z range: Start 6.0, End 42.5, Spacing 7.0
-      // We place rays slightly outside the flowers (e.g., X = +/- 6.5)
-      // and along the same Z intervals.
-
-      float flowerStartZ = 2.7f;
-      float flowerEndZ = 42.5f;
-      float rayOffsetFromFlower = 0.95f; // Distance from flower center
-
-      for (float z = flowerStartZ; z <= flowerEndZ; z += FLOWER_SPACING_Z) {
-        for (int row = 0; row < FLOWER_ROWS; row++) {
-          float flowerX = FLOWER_OFFSET_X_START + row * FLOWER_SPACING_X;
-
-          // Two rays per flower (flanking)
-          float rayX1 = flowerX - rayOffsetFromFlower;
-          float rayX2 = flowerX + rayOffsetFromFlower;
-
-          // --- Ray 1 (Inner side of flower) ---
-          // Left Side
-          mat4 modelRayLeft1 = identity();
-          modelRayLeft1 = mat4_multiply(translate(-rayX1, GODRAY_OFFSET_Y, z),
-                                        modelRayLeft1);
-          Shader_SetMat4(godrayShader, "model", modelRayLeft1.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Right Side
-          mat4 modelRayRight1 = identity();
-          modelRayRight1 = mat4_multiply(translate(rayX1, GODRAY_OFFSET_Y, z),
-                                         modelRayRight1);
-          Shader_SetMat4(godrayShader, "model", modelRayRight1.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Far Side Left
-          mat4 modelRayLeftFar1 = identity();
-          modelRayLeftFar1 = mat4_multiply(
-              translate(-rayX1, GODRAY_OFFSET_Y, -z), modelRayLeftFar1);
-          Shader_SetMat4(godrayShader, "model", modelRayLeftFar1.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Far Side Right
-          mat4 modelRayRightFar1 = identity();
-          modelRayRightFar1 = mat4_multiply(
-              translate(rayX1, GODRAY_OFFSET_Y, -z), modelRayRightFar1);
-          Shader_SetMat4(godrayShader, "model", modelRayRightFar1.m);
-          Mesh_Draw(&godrayMesh);
-
-          // --- Ray 2 (Outer side of flower) ---
-          // Left Side
-          mat4 modelRayLeft2 = identity();
-          modelRayLeft2 = mat4_multiply(translate(-rayX2, GODRAY_OFFSET_Y, z),
-                                        modelRayLeft2);
-          Shader_SetMat4(godrayShader, "model", modelRayLeft2.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Right Side
-          mat4 modelRayRight2 = identity();
-          modelRayRight2 = mat4_multiply(translate(rayX2, GODRAY_OFFSET_Y, z),
-                                         modelRayRight2);
-          Shader_SetMat4(godrayShader, "model", modelRayRight2.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Far Side Left
-          mat4 modelRayLeftFar2 = identity();
-          modelRayLeftFar2 = mat4_multiply(
-              translate(-rayX2, GODRAY_OFFSET_Y, -z), modelRayLeftFar2);
-          Shader_SetMat4(godrayShader, "model", modelRayLeftFar2.m);
-          Mesh_Draw(&godrayMesh);
-
-          // Far Side Right
-          mat4 modelRayRightFar2 = identity();
-          modelRayRightFar2 = mat4_multiply(
-              translate(rayX2, GODRAY_OFFSET_Y, -z), modelRayRightFar2);
-          Shader_SetMat4(godrayShader, "model", modelRayRightFar2.m);
-          Mesh_Draw(&godrayMesh);
-        }
-      }
+      StaticBatch_Draw(&rayBatch, &frustum, &occlusion, reflectionPass,
+                       &lodView);
 
-      glDepthMask(GL_TRUE);
-      glDisable(GL_BLEND);
+      GLState_DepthMask(GL_TRUE);
+      GLState_Disable(GL_BLEND);
+      Profiler_End();
 
       // Restore Camera
       if (pass == 0) {
         camera.Position = savedCameraPos;
         camera.Pitch = savedCameraPitch;
         Camera_UpdateVectors(&camera);
-        glEnable(GL_CULL_FACE);
+        GLState_Enable(GL_CULL_FACE);
       }
 
       // Draw Water (Pass 2)
       if (pass == 2) {
+        Profiler_Begin("water");
         Shader_Use(waterShader);
-        mat4 view = Camera_GetViewMatrix(&camera);
-        mat4 proj =
-            perspective(1.57f, (float)width / (float)height, 0.1f, 2000.0f);
         mat4 model = identity();
         model = mat4_multiply(scale(1.43f, 1.0f, 0.05f), model);
         model = mat4_multiply(translate(0.0f, WATER_HEIGHT, 0.0f), model);
 
-        Shader_SetMat4(waterShader, "view", view.m);
-        Shader_SetMat4(waterShader, "projection", proj.m);
         Shader_SetMat4(waterShader, "model", model.m);
-        Shader_SetVec3(waterShader, "cameraPosition", camera.Position.x,
-                       camera.Position.y, camera.Position.z);
         Shader_SetVec3(waterShader, "lightPosition", 0.5f, -0.05f, -0.5f);
         Shader_SetVec3(waterShader, "lightColor", 1.0f, 0.6f, 0.4f);
-        Shader_SetVec3(waterShader, "skyColor", skyColor.x, skyColor.y,
-                       skyColor.z);
         Shader_SetFloat(waterShader, "moveFactor", waterMoveFactor);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, waterFBOs.reflectionTexture);
+        GLState_BindTexture(0, waterFBOs.reflectionTexture);
         Shader_SetInt(waterShader, "reflectionTexture", 0);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, waterFBOs.refractionTexture);
+        GLState_BindTexture(1, waterFBOs.refractionTexture);
         Shader_SetInt(waterShader, "refractionTexture", 1);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, waterDUDV);
+        GLState_BindTexture(2, waterDUDV);
         Shader_SetInt(waterShader, "dudvMap", 2);
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, normalMap);
+        GLState_BindTexture(3, normalMap);
         Shader_SetInt(waterShader, "normalMap", 3);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, waterFBOs.refractionDepthTexture);
+        GLState_BindTexture(4, waterFBOs.refractionDepthTexture);
         Shader_SetInt(waterShader, "depthMap", 4);
 
         Mesh_Draw(&waterMesh);
+        Profiler_End();
       }
+      Profiler_End();
     } // End for loop
 
+    if (bench.enabled) {
+      Bench_EndFrame(&bench);
+      glfwPollEvents();
+      continue;
+    }
+
+    Overlay_Render(width, height, deltaTime * 1000.0f);
+
     glfwSwapBuffers(window);
     glfwPollEvents();
 
-    // DEBUG: Player Position (Easy to remove)
-    printf("Player Pos: %.2f, %.2f, %.2f\n", camera.Position.x,
-           camera.Position.y, camera.Position.z);
+    // DEBUG: Player Position (LOG_LEVEL=debug to see it every frame)
+    Log_Debug("Player Pos: %.2f, %.2f, %.2f", camera.Position.x,
+              camera.Position.y, camera.Position.z);
     static int frameCount = 0;
     if (frameCount++ % 60 == 0) { // Print once every 60 frames to avoid spam
-      printf("Player Pos: %.2f, %.2f, %.2f\n", camera.Position.x,
-             camera.Position.y, camera.Position.z);
+      Log_Info("Player Pos: %.2f, %.2f, %.2f", camera.Position.x,
+               camera.Position.y, camera.Position.z);
+      RenderStats stats = RenderStats_Get();
+      Log_Info("Render Stats: %d draws, %d triangles, %d visible, %d culled "
+               "(%d occluded)",
+               stats.drawCalls, stats.triangles, stats.visible, stats.culled,
+               stats.occluded);
+      GLStateStats stateStats = GLState_GetStats();
+      Log_Info("GL State: %d calls issued, %d filtered",
+               stateStats.issued - frameStateStats.issued,
+               stateStats.filtered - frameStateStats.filtered);
+      Profiler_Report();
     }
   }
 
+  int status = 0;
+  if (bench.enabled) {
+    Profiler_Report();
+    status = Bench_WriteResults(&bench) ? 0 : 1;
+    Bench_Destroy(&bench);
+  }
+
   WaterFBO_CleanUp(&waterFBOs);
   glfwTerminate();
-  return 0;
+  Log_Shutdown();
+  return status;
 }
@@ -0,0 +1,96 @@
+// Microbenchmark for the OBJ parser.
+// Usage: ./obj_bench [-n runs] [model.obj ...]
+// Without model arguments it measures the models bundled under materials/.
+#include "../utils/obj_parser.h"
+#include "../utils/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static const char *defaultModels[] = {
+    "../materials/gazebo/rgazebo.obj",
+    "../materials/bridge/bridge.obj",
+    "../materials/halfpipe/halfpipe.obj",
+    "../materials/flower/rflower.obj",
+    "../materials/flower_w/rflower_w_pbr.obj",
+    "../materials/hedge/source/hedge-obj/rhedgeTextured.obj",
+    "../materials/hedge/source/hedge-obj/hedgeTextured.obj",
+    "../materials/castle/rcastle.obj",
+};
+
+static double nowSeconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Best-of-runs parse time in seconds, or a negative value on failure
+static double timeParse(const char *path, ThreadPool *pool, int runs,
+                        int *faceCount) {
+  double best = -1.0;
+  for (int r = 0; r < runs; r++) {
+    ObjData data;
+    double t0 = nowSeconds();
+    if (!ObjParser_Parse(path, pool, &data))
+      return -1.0;
+    double t = nowSeconds() - t0;
+    if (best < 0.0 || t < best)
+      best = t;
+    *faceCount = data.faceCount;
+    ObjData_Free(&data);
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  int runs = 5;
+  const char **models = defaultModels;
+  int modelCount = (int)(sizeof(defaultModels) / sizeof(defaultModels[0]));
+
+  int argi = 1;
+  if (argi + 1 < argc && strcmp(argv[argi], "-n") == 0) {
+    runs = atoi(argv[argi + 1]);
+    if (runs < 1)
+      runs = 1;
+    argi += 2;
+  }
+  if (argi < argc) {
+    models = (const char **)&argv[argi];
+    modelCount = argc - argi;
+  }
+
+  ThreadPool *pool = ThreadPool_GetDefault();
+  printf("obj_bench: %d worker threads, best of %d runs\n",
+         ThreadPool_GetThreadCount(pool), runs);
+  printf("%-58s %9s %10s %10s %8s\n", "model", "MB", "1T MB/s", "MT MB/s",
+         "faces");
+
+  double totalMB = 0.0, totalSingle = 0.0, totalMulti = 0.0;
+  for (int i = 0; i < modelCount; i++) {
+    struct stat st;
+    if (stat(models[i], &st) != 0) {
+      printf("%-58s (missing, skipped)\n", models[i]);
+      continue;
+    }
+    double mb = st.st_size / (1024.0 * 1024.0);
+    int faces = 0;
+    double single = timeParse(models[i], NULL, runs, &faces);
+    double multi = timeParse(models[i], pool, runs, &faces);
+    if (single <= 0.0 || multi <= 0.0) {
+      printf("%-58s (parse failed)\n", models[i]);
+      continue;
+    }
+    printf("%-58s %9.2f %10.1f %10.1f %8d\n", models[i], mb, mb / single,
+           mb / multi, faces);
+    totalMB += mb;
+    totalSingle += single;
+    totalMulti += multi;
+  }
+
+  if (totalMB > 0.0)
+    printf("%-58s %9.2f %10.1f %10.1f\n", "total", totalMB,
+           totalMB / totalSingle, totalMB / totalMulti);
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "log.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_FLUSH_INTERVAL_NS 2000000 // writer thread poll period (2 ms)
+
+// Bounded MPSC queue (Vyukov). A slot is free for position p when its
+// sequence equals p and holds a message for p when it equals p + 1.
+typedef struct {
+  unsigned int sequence;
+  LogLevel level;
+  double time;
+  char text[LOG_MESSAGE_MAX];
+} LogSlot;
+
+static LogSlot ring[LOG_RING_SIZE];
+static unsigned int ringTail = 0; // next position producers claim
+static unsigned int ringHead = 0; // next position the writer reads
+static pthread_once_t ringOnce = PTHREAD_ONCE_INIT;
+static unsigned int dropped = 0;
+
+static LogLevel minLevel = LOG_INFO;
+static FILE *logFile = NULL;
+static pthread_t writer;
+static int running = 0;
+static int stopRequested = 0;
+static double startTime = 0.0;
+
+static const char *levelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+// CLOCK_MONOTONIC is served from the vDSO, no syscall
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1.0e9;
+}
+
+static void initRing(void) {
+  for (unsigned int i = 0; i < LOG_RING_SIZE; i++)
+    ring[i].sequence = i;
+  startTime = now();
+}
+
+// Writes every published message; returns how many were written
+static int drain(void) {
+  int written = 0;
+  for (;;) {
+    LogSlot *slot = &ring[ringHead & LOG_RING_MASK];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != ringHead + 1)
+      break;
+    char line[LOG_MESSAGE_MAX + 32];
+    snprintf(line, sizeof(line), "[%9.3f] %-5s %s\n", slot->time - startTime,
+             levelNames[slot->level], slot->text);
+    __atomic_store_n(&slot->sequence, ringHead + LOG_RING_SIZE,
+                     __ATOMIC_RELEASE);
+    ringHead++;
+
+    fputs(line, stdout);
+    if (logFile)
+      fputs(line, logFile);
+    written++;
+  }
+
+  unsigned int lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+  if (lost > 0) {
+    printf("[%9.3f] WARN  Log: %u messages dropped (ring full)\n",
+           now() - startTime, lost);
+    written++;
+  }
+  if (written > 0) {
+    fflush(stdout);
+    if (logFile)
+      fflush(logFile);
+  }
+  return written;
+}
+
+static void *writerMain(void *arg) {
+  (void)arg;
+  struct timespec pause = {0, LOG_FLUSH_INTERVAL_NS};
+  while (!__atomic_load_n(&stopRequested, __ATOMIC_ACQUIRE)) {
+    if (drain() == 0)
+      nanosleep(&pause, NULL);
+  }
+  drain();
+  return NULL;
+}
+
+void Log_Init(const char *filePath) {
+  if (running)
+    return;
+  pthread_once(&ringOnce, initRing);
+
+  const char *env = getenv("LOG_LEVEL");
+  if (env) {
+    for (int i = LOG_DEBUG; i <= LOG_ERROR; i++)
+      if (strcasecmp(env, levelNames[i]) == 0)
+        minLevel = (LogLevel)i;
+  }
+
+  if (filePath) {
+    logFile = fopen(filePath, "w");
+    if (!logFile)
+      printf("Log: could not open %s\n", filePath);
+  }
+
+  stopRequested = 0;
+  running = pthread_create(&writer, NULL, writerMain, NULL) == 0;
+  if (!running)
+    printf("Log: could not start writer thread\n");
+}
+
+void Log_Shutdown(void) {
+  if (running) {
+    __atomic_store_n(&stopRequested, 1, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    running = 0;
+  } else {
+    pthread_once(&ringOnce, initRing);
+    drain();
+  }
+  if (logFile) {
+    fclose(logFile);
+    logFile = NULL;
+  }
+}
+
+void Log_SetLevel(LogLevel level) { minLevel = level; }
+
+int Log_IsEnabled(LogLevel level) { return level >= minLevel; }
+
+void Log_Write(LogLevel level, const char *fmt, ...) {
+  if (level < minLevel)
+    return;
+  // Messages logged before Log_Init are queued and written once it runs
+  pthread_once(&ringOnce, initRing);
+
+  // Claim a position whose slot the writer has released
+  unsigned int pos = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+  LogSlot *slot;
+  for (;;) {
+    slot = &ring[pos & LOG_RING_MASK];
+    unsigned int seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    int diff = (int)(seq - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ringTail, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0) {
+      __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+      return;
+    } else {
+      pos = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+    }
+  }
+
+  slot->level = level;
+  slot->time = now();
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(slot->text, LOG_MESSAGE_MAX, fmt, args);
+  va_end(args);
+  __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+}
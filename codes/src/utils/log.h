@@ -0,0 +1,30 @@
+#ifndef LOG_H
+#define LOG_H
+
+typedef enum { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR } LogLevel;
+
+#define LOG_RING_SIZE 1024 // power of two
+#define LOG_MESSAGE_MAX 200
+
+// Asynchronous logger. Any thread formats its message into a slot of a
+// lock-free ring; a background thread writes the slots to stdout (and the
+// optional file). Log_Write never blocks or makes a syscall: when the ring
+// is full the message is dropped and counted.
+
+// filePath may be NULL for stdout only. The LOG_LEVEL environment variable
+// (debug, info, warn, error) overrides the default level of info.
+void Log_Init(const char *filePath);
+// Writes everything still queued and stops the writer thread
+void Log_Shutdown(void);
+void Log_SetLevel(LogLevel level);
+int Log_IsEnabled(LogLevel level);
+// Appends the newline itself
+void Log_Write(LogLevel level, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#define Log_Debug(...) Log_Write(LOG_DEBUG, __VA_ARGS__)
+#define Log_Info(...) Log_Write(LOG_INFO, __VA_ARGS__)
+#define Log_Warn(...) Log_Write(LOG_WARN, __VA_ARGS__)
+#define Log_Error(...) Log_Write(LOG_ERROR, __VA_ARGS__)
+
+#endif
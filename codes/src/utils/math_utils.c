@@ -158,3 +158,20 @@ mat4 rotate_z(float angle) {
   res.m[5] = c;
   return res;
 }
+
+void mat4_normal_matrix(mat4 model, float out[9]) {
+  const float *a = &model.m[0]; // columns of the 3x3
+  const float *b = &model.m[4];
+  const float *c = &model.m[8];
+  // The inverse has rows (b x c, c x a, a x b) / det, so the inverse
+  // transpose has them as columns
+  float cols[9] = {b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2],
+                   b[0] * c[1] - b[1] * c[0], c[1] * a[2] - c[2] * a[1],
+                   c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0],
+                   a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                   a[0] * b[1] - a[1] * b[0]};
+  float det = a[0] * cols[0] + a[1] * cols[1] + a[2] * cols[2];
+  float inv = det != 0.0f ? 1.0f / det : 0.0f;
+  for (int i = 0; i < 9; i++)
+    out[i] = cols[i] * inv;
+}
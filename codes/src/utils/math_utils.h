@@ -56,5 +56,8 @@ mat4 translate(float x, float y, float z);
 mat4 scale(float x, float y, float z);
 mat4 rotate_x(float angle);
 mat4 rotate_y(float angle);
+// Inverse transpose of the upper 3x3 of model as a column-major mat3. Keeps
+// normals perpendicular under non-uniform scale.
+void mat4_normal_matrix(mat4 model, float out[9]);
 
 #endif
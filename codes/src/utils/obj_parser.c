@@ -0,0 +1,395 @@
+#include "obj_parser.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Files smaller than this are parsed as a single chunk
+#define OBJ_MIN_CHUNK_BYTES (256 * 1024)
+// Corners beyond this are ignored, as the previous fgets loader did. The
+// halfpipe caps are 86-gons that render wrong when fan triangulated.
+#define OBJ_MAX_POLYGON 4
+
+// Per-chunk parse output. Relative (negative) face indices can only be
+// resolved once the counts of the preceding chunks are known, so they are
+// stored relative to the chunk start and flagged in relMask.
+typedef struct {
+  const char *begin;
+  const char *end;
+  float *positions;
+  float *texcoords;
+  float *normals;
+  ObjFace *faces;
+  unsigned short *relMask; // bit (corner * 3 + component)
+  int positionCount, positionCap;
+  int texcoordCount, texcoordCap;
+  int normalCount, normalCap;
+  int faceCount, faceCap;
+} ObjChunk;
+
+// --- Number parsing ---
+// sscanf/strtof are locale aware and dominate the old loader's profile; OBJ
+// only ever needs plain decimal numbers.
+
+static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline int isDigit(char c) { return c >= '0' && c <= '9'; }
+static inline int isBlank(char c) { return c == ' ' || c == '\t'; }
+
+static inline const char *skipBlanks(const char *p, const char *end) {
+  while (p < end && isBlank(*p))
+    p++;
+  return p;
+}
+
+static double pow10d(int e) {
+  double r = 1.0;
+  while (e > 22) {
+    r *= 1e22;
+    e -= 22;
+  }
+  return r * kPow10[e];
+}
+
+static const char *parseFloat(const char *p, const char *end, float *out) {
+  int neg = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0; // significant digits kept in mantissa (max 19)
+  int exp10 = 0;
+  for (; p < end && isDigit(*p); p++) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      if (mantissa)
+        digits++;
+    } else {
+      exp10++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && isDigit(*p); p++) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        if (mantissa)
+          digits++;
+        exp10--;
+      }
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    int expNeg = 0;
+    if (q < end && (*q == '-' || *q == '+')) {
+      expNeg = (*q == '-');
+      q++;
+    }
+    if (q < end && isDigit(*q)) {
+      int e = 0;
+      for (; q < end && isDigit(*q); q++)
+        e = (e < 10000) ? e * 10 + (*q - '0') : e;
+      exp10 += expNeg ? -e : e;
+      p = q;
+    }
+  }
+
+  double v = (double)mantissa;
+  if (exp10 < 0)
+    v /= pow10d(exp10 < -330 ? 330 : -exp10);
+  else if (exp10 > 0)
+    v *= pow10d(exp10 > 330 ? 330 : exp10);
+  *out = (float)(neg ? -v : v);
+  return p;
+}
+
+static const char *parseInt(const char *p, const char *end, int *out) {
+  int neg = 0;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    p++;
+  }
+  int v = 0;
+  for (; p < end && isDigit(*p); p++)
+    v = v * 10 + (*p - '0');
+  *out = neg ? -v : v;
+  return p;
+}
+
+// --- Chunk parsing ---
+
+static void *growArray(void *ptr, int *cap, int need, size_t elemSize) {
+  if (need <= *cap)
+    return ptr;
+  int newCap = (*cap > 0) ? *cap : 1024;
+  while (newCap < need)
+    newCap *= 2;
+  *cap = newCap;
+  return realloc(ptr, (size_t)newCap * elemSize);
+}
+
+static const char *parseFloats(const char *p, const char *end, float *dst,
+                               int n) {
+  for (int i = 0; i < n; i++) {
+    p = skipBlanks(p, end);
+    if (p >= end || !(isDigit(*p) || *p == '-' || *p == '+' || *p == '.')) {
+      dst[i] = 0.0f;
+      continue;
+    }
+    p = parseFloat(p, end, &dst[i]);
+  }
+  return p;
+}
+
+// Converts a raw OBJ index to 0-based. Negative indices count back from the
+// current element; they are stored relative to the chunk start and flagged.
+static inline int resolveIndex(int raw, int localCount, int *isRelative) {
+  *isRelative = 0;
+  if (raw > 0)
+    return raw - 1;
+  if (raw < 0) {
+    *isRelative = 1;
+    return localCount + raw;
+  }
+  return 0;
+}
+
+static void parseFace(ObjChunk *c, const char *p, const char *end) {
+  int v[OBJ_MAX_POLYGON], vt[OBJ_MAX_POLYGON], vn[OBJ_MAX_POLYGON];
+  int count = 0;
+
+  for (;;) {
+    p = skipBlanks(p, end);
+    if (p >= end || !(isDigit(*p) || *p == '-'))
+      break;
+    int rv = 0, rvt = 0, rvn = 0;
+    p = parseInt(p, end, &rv);
+    if (p < end && *p == '/') {
+      p++;
+      if (p < end && *p == '/') { // v//vn
+        p = parseInt(p + 1, end, &rvn);
+      } else { // v/vt or v/vt/vn
+        p = parseInt(p, end, &rvt);
+        if (p < end && *p == '/')
+          p = parseInt(p + 1, end, &rvn);
+      }
+    }
+    // skip anything unexpected up to the next separator
+    while (p < end && !isBlank(*p) && *p != '\n' && *p != '\r')
+      p++;
+    if (count < OBJ_MAX_POLYGON) {
+      v[count] = rv;
+      vt[count] = rvt;
+      vn[count] = rvn;
+      count++;
+    }
+  }
+
+  // Triangulate (Fan triangulation: 0-1-2, 0-2-3, ...)
+  for (int i = 0; i < count - 2; i++) {
+    if (c->faceCount + 1 > c->faceCap) {
+      // faces and relMask share one capacity
+      c->faces = (ObjFace *)growArray(c->faces, &c->faceCap, c->faceCount + 1,
+                                      sizeof(ObjFace));
+      c->relMask = (unsigned short *)realloc(
+          c->relMask, (size_t)c->faceCap * sizeof(unsigned short));
+    }
+    ObjFace *f = &c->faces[c->faceCount];
+    unsigned short mask = 0;
+    int corners[3] = {0, i + 1, i + 2};
+    for (int k = 0; k < 3; k++) {
+      int idx = corners[k], rel;
+      f->v[k] = resolveIndex(v[idx], c->positionCount, &rel);
+      mask |= (unsigned short)(rel << (k * 3 + 0));
+      f->vt[k] = resolveIndex(vt[idx], c->texcoordCount, &rel);
+      mask |= (unsigned short)(rel << (k * 3 + 1));
+      f->vn[k] = resolveIndex(vn[idx], c->normalCount, &rel);
+      mask |= (unsigned short)(rel << (k * 3 + 2));
+    }
+    c->relMask[c->faceCount] = mask;
+    c->faceCount++;
+  }
+}
+
+static void parseChunk(void *arg) {
+  ObjChunk *c = (ObjChunk *)arg;
+  const char *p = c->begin;
+  const char *end = c->end;
+
+  while (p < end) {
+    const char *lineEnd = memchr(p, '\n', (size_t)(end - p));
+    if (!lineEnd)
+      lineEnd = end;
+    p = skipBlanks(p, lineEnd);
+
+    if (lineEnd - p >= 2 && p[0] == 'v') {
+      if (isBlank(p[1])) { // Vertex Position
+        c->positions = (float *)growArray(c->positions, &c->positionCap,
+                                          c->positionCount + 1,
+                                          3 * sizeof(float));
+        parseFloats(p + 2, lineEnd, &c->positions[c->positionCount * 3], 3);
+        c->positionCount++;
+      } else if (p[1] == 't' && lineEnd - p >= 3 &&
+                 isBlank(p[2])) { // Texture Coordinate
+        c->texcoords = (float *)growArray(c->texcoords, &c->texcoordCap,
+                                          c->texcoordCount + 1,
+                                          2 * sizeof(float));
+        parseFloats(p + 3, lineEnd, &c->texcoords[c->texcoordCount * 2], 2);
+        c->texcoordCount++;
+      } else if (p[1] == 'n' && lineEnd - p >= 3 &&
+                 isBlank(p[2])) { // Vertex Normal
+        c->normals = (float *)growArray(c->normals, &c->normalCap,
+                                        c->normalCount + 1, 3 * sizeof(float));
+        parseFloats(p + 3, lineEnd, &c->normals[c->normalCount * 3], 3);
+        c->normalCount++;
+      }
+    } else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1])) { // Face
+      parseFace(c, p + 2, lineEnd);
+    }
+
+    p = lineEnd + 1;
+  }
+}
+
+static void freeChunk(ObjChunk *c) {
+  free(c->positions);
+  free(c->texcoords);
+  free(c->normals);
+  free(c->faces);
+  free(c->relMask);
+}
+
+// --- Public API ---
+
+static inline int clampIndex(int idx, int count) {
+  return (idx >= 0 && idx < count) ? idx : 0;
+}
+
+int ObjParser_Parse(const char *path, ThreadPool *pool, ObjData *out) {
+  memset(out, 0, sizeof(*out));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return 0;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    close(fd);
+    return 1;
+  }
+  const char *data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE,
+                                        fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return 0;
+  madvise((void *)data, size, MADV_SEQUENTIAL);
+
+  // Split into line-aligned chunks, a few per worker for load balancing
+  int threads = pool ? ThreadPool_GetThreadCount(pool) : 1;
+  int chunkCount = (int)(size / OBJ_MIN_CHUNK_BYTES);
+  if (chunkCount > threads * 4)
+    chunkCount = threads * 4;
+  if (chunkCount < 1 || !pool)
+    chunkCount = 1;
+
+  ObjChunk *chunks = (ObjChunk *)calloc(chunkCount, sizeof(ObjChunk));
+  const char *end = data + size;
+  const char *prev = data;
+  for (int i = 0; i < chunkCount; i++) {
+    const char *split = end;
+    if (i + 1 < chunkCount) {
+      split = data + size / chunkCount * (i + 1);
+      if (split < prev)
+        split = prev;
+      const char *nl = memchr(split, '\n', (size_t)(end - split));
+      split = nl ? nl + 1 : end;
+    }
+    chunks[i].begin = prev;
+    chunks[i].end = split;
+    prev = split;
+  }
+
+  if (chunkCount == 1) {
+    parseChunk(&chunks[0]);
+  } else {
+    ThreadPoolGroup group = {0};
+    for (int i = 0; i < chunkCount; i++)
+      ThreadPool_Submit(pool, &group, parseChunk, &chunks[i]);
+    ThreadPool_Wait(pool, &group);
+  }
+
+  // Merge chunk arrays in file order
+  for (int i = 0; i < chunkCount; i++) {
+    out->positionCount += chunks[i].positionCount;
+    out->texcoordCount += chunks[i].texcoordCount;
+    out->normalCount += chunks[i].normalCount;
+    out->faceCount += chunks[i].faceCount;
+  }
+  // One zeroed spare element so index 0 stays readable for empty arrays
+  out->positions =
+      (float *)calloc((size_t)out->positionCount + 1, 3 * sizeof(float));
+  out->texcoords =
+      (float *)calloc((size_t)out->texcoordCount + 1, 2 * sizeof(float));
+  out->normals =
+      (float *)calloc((size_t)out->normalCount + 1, 3 * sizeof(float));
+  out->faces = (ObjFace *)malloc(((size_t)out->faceCount + 1) * sizeof(ObjFace));
+
+  int vBase = 0, vtBase = 0, vnBase = 0, fBase = 0;
+  for (int i = 0; i < chunkCount; i++) {
+    ObjChunk *c = &chunks[i];
+    memcpy(out->positions + (size_t)vBase * 3, c->positions,
+           (size_t)c->positionCount * 3 * sizeof(float));
+    memcpy(out->texcoords + (size_t)vtBase * 2, c->texcoords,
+           (size_t)c->texcoordCount * 2 * sizeof(float));
+    memcpy(out->normals + (size_t)vnBase * 3, c->normals,
+           (size_t)c->normalCount * 3 * sizeof(float));
+
+    for (int f = 0; f < c->faceCount; f++) {
+      ObjFace face = c->faces[f];
+      unsigned short mask = c->relMask[f];
+      for (int k = 0; k < 3; k++) {
+        if (mask & (1u << (k * 3 + 0)))
+          face.v[k] += vBase;
+        if (mask & (1u << (k * 3 + 1)))
+          face.vt[k] += vtBase;
+        if (mask & (1u << (k * 3 + 2)))
+          face.vn[k] += vnBase;
+        face.v[k] = clampIndex(face.v[k], out->positionCount);
+        face.vt[k] = clampIndex(face.vt[k], out->texcoordCount);
+        face.vn[k] = clampIndex(face.vn[k], out->normalCount);
+      }
+      out->faces[fBase + f] = face;
+    }
+
+    vBase += c->positionCount;
+    vtBase += c->texcoordCount;
+    vnBase += c->normalCount;
+    fBase += c->faceCount;
+    freeChunk(c);
+  }
+
+  free(chunks);
+  munmap((void *)data, size);
+  return 1;
+}
+
+void ObjData_Free(ObjData *data) {
+  free(data->positions);
+  free(data->texcoords);
+  free(data->normals);
+  free(data->faces);
+  memset(data, 0, sizeof(*data));
+}
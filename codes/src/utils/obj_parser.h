@@ -0,0 +1,28 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include "thread_pool.h"
+
+// One triangle; indices are 0-based (missing vt/vn components are 0)
+typedef struct {
+  int v[3], vt[3], vn[3];
+} ObjFace;
+
+typedef struct {
+  float *positions; // xyz
+  float *texcoords; // uv
+  float *normals;   // xyz
+  ObjFace *faces;
+  int positionCount;
+  int texcoordCount;
+  int normalCount;
+  int faceCount;
+} ObjData;
+
+// Memory-maps path and parses line-aligned chunks of it in parallel on pool
+// (NULL runs everything on the calling thread). Polygons are fan
+// triangulated. Returns 0 if the file cannot be read.
+int ObjParser_Parse(const char *path, ThreadPool *pool, ObjData *out);
+void ObjData_Free(ObjData *data);
+
+#endif
@@ -0,0 +1,147 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct ThreadPoolJob {
+  ThreadPoolJobFn fn;
+  void *arg;
+  ThreadPoolGroup *group;
+  struct ThreadPoolJob *next;
+} ThreadPoolJob;
+
+struct ThreadPool {
+  pthread_mutex_t lock;
+  pthread_cond_t jobAvailable;
+  pthread_cond_t progress;
+  ThreadPoolJob *head;
+  ThreadPoolJob *tail;
+  pthread_t *threads;
+  int threadCount;
+  int shutdown;
+};
+
+// Pops the next job. Caller must hold the lock.
+static ThreadPoolJob *popJob(ThreadPool *pool) {
+  ThreadPoolJob *job = pool->head;
+  if (job) {
+    pool->head = job->next;
+    if (!pool->head)
+      pool->tail = NULL;
+  }
+  return job;
+}
+
+// Runs job without the lock held, then retires it from its group.
+static void runJob(ThreadPool *pool, ThreadPoolJob *job) {
+  pthread_mutex_unlock(&pool->lock);
+  job->fn(job->arg);
+  pthread_mutex_lock(&pool->lock);
+  job->group->pending--;
+  if (job->group->pending == 0)
+    pthread_cond_broadcast(&pool->progress);
+  free(job);
+}
+
+static void *workerMain(void *arg) {
+  ThreadPool *pool = (ThreadPool *)arg;
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    ThreadPoolJob *job = popJob(pool);
+    if (job) {
+      runJob(pool, job);
+      continue;
+    }
+    if (pool->shutdown)
+      break;
+    pthread_cond_wait(&pool->jobAvailable, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+ThreadPool *ThreadPool_Create(int threadCount) {
+  if (threadCount <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = (cores > 0) ? (int)cores : 1;
+  }
+
+  ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->jobAvailable, NULL);
+  pthread_cond_init(&pool->progress, NULL);
+  pool->threads = (pthread_t *)malloc(threadCount * sizeof(pthread_t));
+  for (int i = 0; i < threadCount; i++) {
+    if (pthread_create(&pool->threads[i], NULL, workerMain, pool) != 0)
+      break;
+    pool->threadCount++;
+  }
+  return pool;
+}
+
+void ThreadPool_Destroy(ThreadPool *pool) {
+  if (!pool)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->jobAvailable);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->threadCount; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->progress);
+  pthread_cond_destroy(&pool->jobAvailable);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
+
+static ThreadPool *defaultPool = NULL;
+static pthread_once_t defaultPoolOnce = PTHREAD_ONCE_INIT;
+
+static void createDefaultPool(void) { defaultPool = ThreadPool_Create(0); }
+
+ThreadPool *ThreadPool_GetDefault(void) {
+  pthread_once(&defaultPoolOnce, createDefaultPool);
+  return defaultPool;
+}
+
+int ThreadPool_GetThreadCount(const ThreadPool *pool) {
+  return pool->threadCount;
+}
+
+void ThreadPool_Submit(ThreadPool *pool, ThreadPoolGroup *group,
+                       ThreadPoolJobFn fn, void *arg) {
+  ThreadPoolJob *job = (ThreadPoolJob *)malloc(sizeof(ThreadPoolJob));
+  job->fn = fn;
+  job->arg = arg;
+  job->group = group;
+  job->next = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  group->pending++;
+  if (pool->tail)
+    pool->tail->next = job;
+  else
+    pool->head = job;
+  pool->tail = job;
+  pthread_cond_signal(&pool->jobAvailable);
+  // Threads sleeping in ThreadPool_Wait can pick the new job up as well
+  pthread_cond_broadcast(&pool->progress);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void ThreadPool_Wait(ThreadPool *pool, ThreadPoolGroup *group) {
+  pthread_mutex_lock(&pool->lock);
+  while (group->pending > 0) {
+    // Help out instead of sleeping; this also keeps nested waits from
+    // deadlocking when every worker is blocked in a wait of its own.
+    ThreadPoolJob *job = popJob(pool);
+    if (job)
+      runJob(pool, job);
+    else
+      pthread_cond_wait(&pool->progress, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
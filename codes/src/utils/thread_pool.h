@@ -0,0 +1,26 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+typedef void (*ThreadPoolJobFn)(void *arg);
+
+typedef struct ThreadPool ThreadPool;
+
+// Tracks a set of submitted jobs so a caller can wait for just those
+typedef struct {
+  int pending;
+} ThreadPoolGroup;
+
+// threadCount <= 0 uses one worker per online core
+ThreadPool *ThreadPool_Create(int threadCount);
+void ThreadPool_Destroy(ThreadPool *pool);
+// Process wide pool, created on first use
+ThreadPool *ThreadPool_GetDefault(void);
+int ThreadPool_GetThreadCount(const ThreadPool *pool);
+
+void ThreadPool_Submit(ThreadPool *pool, ThreadPoolGroup *group,
+                       ThreadPoolJobFn fn, void *arg);
+// Blocks until every job of group finished. The caller runs queued jobs while
+// it waits, so jobs may themselves submit and wait on nested groups.
+void ThreadPool_Wait(ThreadPool *pool, ThreadPoolGroup *group);
+
+#endif